@@ -0,0 +1,184 @@
+#!/bin/bash
+
+# find the fastest instantiation of a kernel template by generating and timing all variants
+#
+# usage: ./autotune.sh <input dir> <kernel file> <kernel name> <parameter space> <driver> [<manifest>]
+#
+# the parameter space lists the values of each template parameter (in order) and the argument
+# types of the kernel, which may refer to the template arguments with $1, $2, ...
+# (tab-separated, values separated by ';', lines starting with '#' are ignored):
+#
+#   T       float;float4;float8
+#   TILE    8;16;32
+#   args    $1 *;int
+#
+# every combination of values is instantiated through patos' explicit instantiation (-e) into
+# a separate output directory and then run by the driver for every input size:
+#
+#   <driver> <translated kernel file> <mangled kernel name> <input size>
+#
+# the driver builds the program (with the options in $AUTOTUNE_BUILD_OPTIONS), runs the kernel
+# on the input of the given size and prints the runtime in seconds as the last line of its output
+# it exits with a non-zero status if the variant fails (e.g. wrong result), which excludes the variant
+#
+# the input sizes are taken from SIZES (default: "1024 65536 1048576"), every measurement is
+# repeated REPEAT times (default: 3) and the minimum is used; additional arguments for patos can be
+# passed with PATOS_FLAGS (e.g. PATOS_FLAGS="--inline-threshold 8")
+# POCL_DEVICES defaults to 'pthread', so that drivers using pocl run on the CPU
+#
+# all measurements are written as tab-separated values to <manifest>.tsv:
+#
+#   size  template arguments  mangled name  runtime_s
+#
+# the fastest variant per input size is written to <manifest> (default: autotune_instantiations.txt)
+# in the format of instantiation lists, i.e. it can be passed to patos with --instantiations
+
+set -o pipefail
+
+SIZES=${SIZES:-"1024 65536 1048576"}
+REPEAT=${REPEAT:-3}
+export POCL_DEVICES=${POCL_DEVICES:-pthread}
+
+if [ $# -lt 5 ] || [ ! -d "$1" ] || [ ! -f "$1/$2" ] || [ ! -f "$4" ] || [ ! -x "$5" ]; then
+    echo "usage: $0 <input dir> <kernel file> <kernel name> <parameter space> <driver> [<manifest>]" >&2
+    exit 1
+fi
+
+input_dir=$1
+kernel_file=$2
+kernel_name=$3
+space_file=$4
+driver=$(cd "$(dirname "$5")" && pwd)/$(basename "$5")
+patos="$(cd "$(dirname "$0")" && pwd)/patos.sh"
+manifest=${6:-autotune_instantiations.txt}
+result_file=$manifest.tsv
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# read parameter space
+parameters=()
+argument_types=""
+while IFS=$'\t' read -r name values; do
+    if [ -z "$name" ] || [ "${name:0:1}" = "#" ]; then
+        continue
+    fi
+
+    if [ "$name" = "args" ]; then
+        argument_types=$values
+    else
+        parameters+=("$values")
+    fi
+done < "$space_file"
+
+# enumerate all combinations of template arguments (one line per variant, separated by ';')
+variants=("")
+for values in "${parameters[@]}"; do
+    IFS=';' read -r -a value_list <<< "$values"
+
+    extended=()
+    for variant in "${variants[@]}"; do
+        for value in "${value_list[@]}"; do
+            extended+=("${variant:+$variant;}$value")
+        done
+    done
+    variants=("${extended[@]}")
+done
+
+echo "${#variants[@]} variant(s), input sizes: $SIZES"
+
+printf "size\ttemplate arguments\tmangled name\truntime_s\n" > "$result_file"
+
+variant_idx=0
+for variant in "${variants[@]}"; do
+    variant_idx=$((variant_idx + 1))
+    IFS=';' read -r -a template_arguments <<< "$variant"
+
+    # substitute the template arguments in the argument types ($1, $2, ...)
+    types=$argument_types
+    for ((idx = ${#template_arguments[@]}; idx >= 1; --idx)); do
+        types=${types//\$$idx/${template_arguments[$((idx - 1))]}}
+    done
+    IFS=';' read -r -a type_list <<< "$types"
+
+    # answers for the explicit instantiation
+    {
+        echo "$kernel_file"
+        echo "$kernel_name"
+        echo "${#template_arguments[@]}"
+        if [ ${#template_arguments[@]} -gt 0 ]; then printf "%s\n" "${template_arguments[@]}"; fi
+        echo "${#type_list[@]}"
+        if [ ${#type_list[@]} -gt 0 ]; then printf "%s\n" "${type_list[@]}"; fi
+    } > "$work_dir/answers"
+
+    output_dir=$work_dir/variant$variant_idx
+    if ! "$patos" -i "$input_dir" -o "$output_dir" -e $PATOS_FLAGS < "$work_dir/answers" > "$work_dir/patos.log" 2>&1; then
+        echo "error: translation of <$variant> failed:" >&2
+        cat "$work_dir/patos.log" >&2
+        continue
+    fi
+
+    # patos prints the name of the instantiation even with -q
+    mangled_name=$(awk -F '\t' '$1 == "patos-kernel" { name = $2 } END { print name }' "$work_dir/patos.log")
+    if [ -z "$mangled_name" ]; then
+        echo "error: patos printed no kernel name for <$variant>:" >&2
+        cat "$work_dir/patos.log" >&2
+        continue
+    fi
+    translated_file=$output_dir/$kernel_file
+
+    export AUTOTUNE_BUILD_OPTIONS="-I $output_dir -I $(dirname "$translated_file")"
+
+    for size in $SIZES; do
+        best="-"
+        for ((run = 0; run < REPEAT; ++run)); do
+            if ! runtime=$("$driver" "$translated_file" "$mangled_name" "$size" 2> "$work_dir/stderr" | tail -n 1); then
+                echo "error: <$variant> failed for size $size:" >&2
+                cat "$work_dir/stderr" >&2
+                best="-"
+                break
+            fi
+
+            if ! [[ $runtime =~ ^[0-9]*\.?[0-9]+([eE][-+]?[0-9]+)?$ ]]; then
+                echo "error: driver printed no runtime for <$variant> (size $size): $runtime" >&2
+                best="-"
+                break
+            fi
+
+            if [ "$best" = "-" ] || awk -v a="$runtime" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+                best=$runtime
+            fi
+        done
+
+        printf "%s\t%s\t%s\t%s\n" "$size" "$variant" "$mangled_name" "$best" >> "$result_file"
+        echo "size $size: <$variant> $best s"
+    done
+done
+
+# fastest variant per input size, as instantiation list (with the input size in a comment)
+{
+    echo "# launch count	kernel file	kernel	template arguments	argument types"
+
+    awk -F '\t' -v kernel_file="$kernel_file" -v kernel_name="$kernel_name" -v argument_types="$argument_types" '
+        NR > 1 && $4 != "-" && (!($1 in best) || $4 + 0 < best[$1] + 0) {
+            if (!($1 in best)) { sizes[++n] = $1 }
+            best[$1] = $4; variant[$1] = $2; name[$1] = $3
+        }
+        END {
+            for (i = 1; i <= n; ++i) {
+                size = sizes[i]
+                count = split(variant[size], arguments, ";")
+                types = argument_types
+                for (idx = count; idx >= 1; --idx) { gsub("\\$" idx, arguments[idx], types) }
+                printf "# size %s: %s (%s s)\n", size, name[size], best[size]
+                printf "1\t%s\t%s\t%s\t%s\n", kernel_file, kernel_name, variant[size], types
+            }
+        }' "$result_file"
+} > "$manifest"
+
+echo "measurements written to $result_file, fastest variants written to $manifest"
+
+if ! grep -q '^1' "$manifest"; then
+    echo "no variant succeeded" >&2
+    exit 1
+fi
@@ -1,3 +1,3 @@
 #!/bin/bash
 
-echo -e "main.m\nmykernel\n2\nint\nComparator<int>\n2\nint *\nint" | ./patos.sh -i sorting_test -o sorting_result -e
+echo -e "main.m\nmykernel\n2\nint\nComparator<int>\n2\nint *\nint" | ./patos.sh -i sorting_test -o sorting_result -e --recursion-reorder-calls
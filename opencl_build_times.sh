@@ -0,0 +1,153 @@
+#!/bin/bash
+
+# measure how long the OpenCL compiler takes for the files generated by patos
+#
+# usage: ./opencl_build_times.sh <patos output directory> [<result file>]
+#
+# every translated file (*.m) is compiled as OpenCL C:
+#   - front-end:  clang -x cl -fsyntax-only
+#   - codegen:    clang -x cl -c (object file, includes the front-end)
+#   - device:     pocl's offline compiler (only if poclcc is available)
+# if llvm-extract and llc are available, the codegen time is also measured per kernel
+# (kernel and everything it calls extracted from the file's LLVM IR)
+#
+# the result is written as tab-separated values (default: opencl_build_times.tsv),
+# one line per file (kernel '-') and one line per kernel:
+#
+#   file  kernel  bytes  lines  records  functions  frontend_s  codegen_s  device_s  object_bytes
+#
+# tools can be overridden by the environment variables CLANG, LLVM_EXTRACT, LLC, POCLCC
+# and additional compiler flags can be passed with OPENCL_FLAGS (e.g. OPENCL_FLAGS="-O2")
+
+CLANG=${CLANG:-clang-3.5}
+LLVM_EXTRACT=${LLVM_EXTRACT:-llvm-extract-3.5}
+LLC=${LLC:-llc-3.5}
+POCLCC=${POCLCC:-poclcc}
+
+if [ $# -lt 1 ] || [ ! -d "$1" ]; then
+    echo "usage: $0 <patos output directory> [<result file>]" >&2
+    exit 1
+fi
+
+output_dir=$1
+result_file=${2:-opencl_build_times.tsv}
+
+if ! command -v "$CLANG" > /dev/null; then
+    echo "error: OpenCL compiler '$CLANG' not found (set CLANG)" >&2
+    exit 1
+fi
+
+per_kernel=0
+if command -v "$LLVM_EXTRACT" > /dev/null && command -v "$LLC" > /dev/null; then
+    per_kernel=1
+else
+    echo "note: $LLVM_EXTRACT/$LLC not found, skipping per-kernel measurements" >&2
+fi
+
+use_pocl=0
+if command -v "$POCLCC" > /dev/null; then
+    use_pocl=1
+fi
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# run a command and print its wall-clock time in seconds ("-" if it failed)
+function measure {
+    local begin end
+    begin=$(date +%s.%N)
+    if "$@" > /dev/null 2> "$work_dir/stderr"; then
+        end=$(date +%s.%N)
+        echo "$begin $end" | awk '{ printf "%.4f", $2 - $1 }'
+    else
+        echo "-"
+    fi
+}
+
+printf "file\tkernel\tbytes\tlines\trecords\tfunctions\tfrontend_s\tcodegen_s\tdevice_s\tobject_bytes\n" > "$result_file"
+
+failures=0
+
+while IFS= read -r -d '' file; do
+    name=${file#$output_dir/}
+
+    bytes=$(wc -c < "$file")
+    lines=$(wc -l < "$file")
+    # flattened records and function prototypes emitted by patos
+    records=$(grep -c '^typedef struct' "$file")
+    functions=$(grep -c ');$' "$file")
+
+    flags=(-x cl -I "$output_dir" -I "$(dirname "$file")" $OPENCL_FLAGS)
+
+    frontend=$(measure "$CLANG" "${flags[@]}" -fsyntax-only "$file")
+    if [ "$frontend" = "-" ]; then
+        echo "error: $name does not compile:" >&2
+        cat "$work_dir/stderr" >&2
+        failures=$((failures + 1))
+    fi
+
+    codegen=$(measure "$CLANG" "${flags[@]}" -c -o "$work_dir/object.o" "$file")
+    object_bytes="-"
+    if [ "$codegen" != "-" ]; then
+        object_bytes=$(wc -c < "$work_dir/object.o")
+    fi
+
+    device="-"
+    if [ $use_pocl -eq 1 ]; then
+        cp "$file" "$work_dir/program.cl"
+        device=$(measure "$POCLCC" -b "-I $output_dir -I $(dirname "$file") $OPENCL_FLAGS" -o "$work_dir/program.pocl" "$work_dir/program.cl")
+    fi
+
+    printf "%s\t-\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n" "$name" "$bytes" "$lines" "$records" "$functions" \
+        "$frontend" "$codegen" "$device" "$object_bytes" >> "$result_file"
+
+    # per-kernel codegen time: extract each kernel (and its callees) from the IR and compile it
+    if [ $per_kernel -eq 1 ] && [ "$frontend" != "-" ] && \
+       "$CLANG" "${flags[@]}" -c -emit-llvm -o "$work_dir/program.bc" "$file" 2> /dev/null; then
+
+        for kernel in $(grep -o '__kernel[[:space:]]\+[A-Za-z_][A-Za-z0-9_]*[[:space:]]\+[A-Za-z_][A-Za-z0-9_]*[[:space:]]*(' "$file" \
+                        | sed -e 's/($//' | awk '{ print $NF }' | sort -u); do
+            if ! "$LLVM_EXTRACT" -func="$kernel" -recursive -o "$work_dir/kernel.bc" "$work_dir/program.bc" 2> /dev/null &&
+               ! "$LLVM_EXTRACT" -func="$kernel" -o "$work_dir/kernel.bc" "$work_dir/program.bc" 2> /dev/null; then
+                continue
+            fi
+
+            kernel_bytes=$(wc -c < "$work_dir/kernel.bc")
+            kernel_codegen=$(measure "$LLC" -filetype=obj -o "$work_dir/kernel.o" "$work_dir/kernel.bc")
+            kernel_object_bytes="-"
+            if [ "$kernel_codegen" != "-" ]; then
+                kernel_object_bytes=$(wc -c < "$work_dir/kernel.o")
+            fi
+
+            printf "%s\t%s\t%s\t-\t-\t-\t-\t%s\t-\t%s\n" "$name" "$kernel" "$kernel_bytes" \
+                "$kernel_codegen" "$kernel_object_bytes" >> "$result_file"
+        done
+    fi
+done < <(find "$output_dir" -name '*.m' -print0 | sort -z)
+
+# summary: totals and correlation of generated size with compile times (per file)
+awk -F '\t' '
+    function correlation(n, sx, sy, sxx, syy, sxy,    p) {
+        # rounding may make the product slightly negative if a column is constant
+        p = (n * sxx - sx * sx) * (n * syy - sy * sy)
+        return (n < 2 || p <= 0) ? "n/a" : sprintf("%.3f", (n * sxy - sx * sy) / sqrt(p))
+    }
+    NR > 1 && $2 == "-" && $7 != "-" && $8 != "-" {
+        n++; files_bytes += $3; frontend += $7; codegen += $8
+        sx += $3; sxx += $3 * $3
+        sf += $7; sff += $7 * $7; sxf += $3 * $7
+        sc += $8; scc += $8 * $8; sxc += $3 * $8
+    }
+    END {
+        printf "files: %d, generated bytes: %d\n", n, files_bytes
+        printf "front-end: %.3f s, codegen: %.3f s\n", frontend, codegen
+        printf "correlation bytes/front-end: %s, bytes/codegen: %s\n", \
+            correlation(n, sx, sf, sxx, sff, sxf), correlation(n, sx, sc, sxx, scc, sxc)
+    }' "$result_file"
+
+echo "results written to $result_file"
+
+if [ $failures -gt 0 ]; then
+    echo "$failures file(s) failed to compile" >&2
+    exit 1
+fi
@@ -30,11 +30,34 @@ bool parseCommandLineArguments(int argc, char **argv, struct Arguments &argument
     po::options_description description("arguments for the Patos source-to-source compiler");
     description.add_options()
         ("help,h", "print help message")
+        ("verbose,v", po::bool_switch(&arguments.Verbose)->default_value(false), "print debug output")
+        ("quiet,q", po::bool_switch(&arguments.Quiet)->default_value(false), "print errors only")
         ("input-dir,i", po::value<std::string>(&arguments.InputDirectory)->required(), "set input directory")
         ("output-dir,o", po::value<std::string>(&arguments.OutputDirectory)->required(), "set output directory")
         ("astdump-dir,d", po::value<std::string>(&arguments.ASTDumpDirectory), "set directory to dump the ASTs to")
         ("include-path,I", po::value<std::vector<std::string>>(&arguments.SystemIncludePaths)->composing(), "add path to list of include paths")
-        ("explicit-instantiation,e", po::bool_switch(&arguments.ExplicitInstantiation)->default_value(false), "ask for explicit instantiation of kernel function");
+        ("explicit-instantiation,e", po::bool_switch(&arguments.ExplicitInstantiation)->default_value(false), "ask for explicit instantiation of kernel function")
+        ("compile-commands,c", po::value<std::string>(&arguments.CompileDatabaseFile), "translate the files listed in a compilation database (compile_commands.json) using their own include paths and macros")
+        ("host-dir", po::value<std::string>(&arguments.HostDirectory), "derive the kernel instantiations from the launch sites in the host sources of a directory")
+        ("instantiations", po::value<std::string>(&arguments.InstantiationListFile), "instantiate the kernels listed in a file")
+        ("write-instantiations", po::value<std::string>(&arguments.WrittenInstantiationListFile), "write the list of kernel instantiations to a file")
+        ("usage-log", po::value<std::string>(&arguments.UsageLogFile), "only instantiate the kernels launched at least --hot-threshold times according to a usage log recorded by the runtime")
+        ("hot-threshold", po::value<unsigned long>(&arguments.HotThreshold)->default_value(1), "minimum number of launches of a hot kernel instantiation")
+        ("lazy-manifest", po::value<std::string>(&arguments.LazyManifestFile), "write the kernel instantiations that are not generated (cold) to a file")
+        ("fold-identical", po::bool_switch(&arguments.FoldIdentical)->default_value(false), "emit functions with identical generated code only once (duplicates forward to it)")
+        ("prune-unreachable", po::bool_switch(&arguments.PruneUnreachable)->default_value(false), "drop generated functions and records that cannot be reached from a kernel")
+        ("amalgamate-dir", po::value<std::string>(&arguments.AmalgamateDirectory), "write a self-contained OpenCL file per kernel (without #include) containing only the code it requires to a directory")
+        ("by-value-max-size", po::value<unsigned long>(&arguments.ByValueMaxSize)->default_value(0), "pass records up to this size (in bytes) by value to their const methods (0: disabled)")
+        ("in-place-min-size", po::value<unsigned long>(&arguments.InPlaceMinSize)->default_value(0), "construct variables of records of at least this size (in bytes) in place instead of copying the constructed record (0: disabled)")
+        ("bloat-report", po::value<std::string>(&arguments.BloatReportFile), "write a report of the emitted template specializations and their code size to a file (JSON, plus a table in <file>.txt)")
+        ("internal-linkage", po::bool_switch(&arguments.InternalLinkage)->default_value(false), "emit generated functions (except kernels) with internal linkage")
+        ("inline-threshold", po::value<unsigned long>(&arguments.InlineThreshold)->default_value(0), "always inline generated functions with fewer statements than this or called inside loops (0: disabled)")
+        ("recursion-stack-depth", po::value<unsigned long>(&arguments.RecursionStackDepth)->default_value(0), "maximum number of frames of the explicit stack self-recursive functions are made iterative with (0: no limit)")
+        ("recursion-reorder-calls", po::bool_switch(&arguments.RecursionReorderCalls)->default_value(false), "execute the smaller of two recursive calls first (the calls have to be independent and their sizes must not add up to more than the size of the current call)")
+        ("optimize-layout", po::bool_switch(&arguments.OptimizeLayout)->default_value(false), "reorder the fields of flattened records to minimize padding (unless the record is shared with the host)")
+        ("layout-report", po::value<std::string>(&arguments.LayoutReportFile), "write size, alignment, field offsets and padding of the flattened records to a file")
+        ("keep-going,k", po::bool_switch(&arguments.KeepGoing)->default_value(false), "continue with the remaining files if the translation of a file fails")
+        ("reproducible,r", po::bool_switch(&arguments.Reproducible)->default_value(false), "emit byte-reproducible output (canonical order of specializations, stable names)");
 
     po::variables_map var_map;
     try
@@ -55,7 +78,48 @@ bool parseCommandLineArguments(int argc, char **argv, struct Arguments &argument
         return false;
     }
 
+    if (arguments.Verbose && arguments.Quiet)
+    {
+        ERROR << "options --verbose and --quiet are mutually exclusive" << std::endl;
+        return false;
+    }
+
     arguments.DumpAST = (var_map.count("astdump-dir") > 0);
+    arguments.UseCompileDatabase = (var_map.count("compile-commands") > 0);
+    arguments.WriteBloatReport = (var_map.count("bloat-report") > 0);
+    arguments.WriteLayoutReport = (var_map.count("layout-report") > 0);
+    arguments.Amalgamate = (var_map.count("amalgamate-dir") > 0);
+    arguments.ScanHostSources = (var_map.count("host-dir") > 0);
+    arguments.ReadInstantiationList = (var_map.count("instantiations") > 0);
+    arguments.WriteInstantiationList = (var_map.count("write-instantiations") > 0);
+
+    if ((arguments.ScanHostSources || arguments.ReadInstantiationList) &&
+        (arguments.ExplicitInstantiation || arguments.UseCompileDatabase))
+    {
+        ERROR << "options --host-dir/--instantiations cannot be combined with --explicit-instantiation or --compile-commands" << std::endl;
+        return false;
+    }
+
+    if (arguments.WriteInstantiationList && !(arguments.ScanHostSources || arguments.ReadInstantiationList))
+    {
+        ERROR << "option --write-instantiations requires --host-dir or --instantiations" << std::endl;
+        return false;
+    }
+
+    arguments.UseUsageLog = (var_map.count("usage-log") > 0);
+    arguments.WriteLazyManifest = (var_map.count("lazy-manifest") > 0);
+
+    if (arguments.UseUsageLog && !(arguments.ScanHostSources || arguments.ReadInstantiationList))
+    {
+        ERROR << "option --usage-log requires --host-dir or --instantiations" << std::endl;
+        return false;
+    }
+
+    if (arguments.WriteLazyManifest && !arguments.UseUsageLog)
+    {
+        ERROR << "option --lazy-manifest requires --usage-log" << std::endl;
+        return false;
+    }
 
     return true;
 }
@@ -33,6 +33,67 @@ struct Arguments
     std::vector<std::string> SystemIncludePaths;
 
     bool ExplicitInstantiation;
+
+    bool Reproducible;
+
+    bool Verbose;
+    bool Quiet;
+
+    bool KeepGoing;
+
+    bool UseCompileDatabase;
+    std::string CompileDatabaseFile;
+
+    bool ScanHostSources;
+    std::string HostDirectory;
+
+    bool ReadInstantiationList;
+    std::string InstantiationListFile;
+
+    bool WriteInstantiationList;
+    std::string WrittenInstantiationListFile;
+
+    bool UseUsageLog;
+    std::string UsageLogFile;
+    unsigned long HotThreshold;
+
+    bool WriteLazyManifest;
+    std::string LazyManifestFile;
+
+    bool FoldIdentical;
+
+    // drop generated code that cannot be reached from a kernel
+    bool PruneUnreachable;
+
+    // write a self-contained file per kernel
+    bool Amalgamate;
+    std::string AmalgamateDirectory;
+
+    // maximum size (in bytes) of records passed by value to const methods (0: always by reference)
+    unsigned long ByValueMaxSize;
+
+    // minimum size (in bytes) of records constructed in place (0: constructors always return by value)
+    unsigned long InPlaceMinSize;
+
+    bool WriteBloatReport;
+    std::string BloatReportFile;
+
+    bool OptimizeLayout;
+
+    // emit generated non-kernel functions as 'static'
+    bool InternalLinkage;
+
+    // generated functions with fewer statements (or called inside loops) are always inlined (0: disabled)
+    unsigned long InlineThreshold;
+
+    // maximum number of frames of the explicit stack of recursive functions made iterative (0: no limit)
+    unsigned long RecursionStackDepth;
+
+    // the smaller of two recursive calls is executed first (bounds the stack by the logarithm of the size)
+    bool RecursionReorderCalls;
+
+    bool WriteLayoutReport;
+    std::string LayoutReportFile;
 };
 
 /**
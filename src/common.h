@@ -18,9 +18,13 @@
 #define __INCLUDE_COMMON_H
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <stdlib.h>
 
 #include "config.h"
+#include "log.h"
 
 #define PRIVATE static
 
@@ -30,14 +34,34 @@
 #define COL_YELLOW  "\e[33m"
 #define COL_CYAN    "\e[36m"
 
-#ifdef DEBUG_MODE 
-    #define DBG std::cout << "[ " << COL_CYAN << "dbg" << COL_CLEAR << " ] "
-#else
-    #define DBG if (false) std::cerr
-#endif
+// NOTE: the message is only constructed if the level is enabled
+// (the 'else' keeps the macro safe to use inside if/else statements)
+#define PATOS_LOG(level) if (!PatosLog::isEnabled(level)) ; else PatosLog::sink()
+
+#define DBG PATOS_LOG(PatosLog::LEVEL_DEBUG) << "[ " << COL_CYAN << "dbg" << COL_CLEAR << " ] "
+#define INFO PATOS_LOG(PatosLog::LEVEL_INFO) << "[" << COL_GREEN << "info" << COL_CLEAR << " ] "
+// NOTE: errors bypass the buffer (after writing what it holds), so that they are not lost if patos crashes
+#define ERROR (PatosLog::flush(), std::cout) << "[" << COL_RED << "error" << COL_CLEAR << "] "
+#define INPUT (PatosLog::flush(), std::cout) << "[" << COL_YELLOW << "input" << COL_CLEAR << "] "
+
+// error that aborts the translation of the current file
+// (thrown inside a pass, caught in PatosConsumer::HandleTranslationUnit)
+class PatosError: public std::runtime_error
+{
+public:
+    explicit PatosError(const std::string &message):
+        std::runtime_error(message)
+    {
+        // intentionally left blank
+    }
+};
 
-#define INFO std::cout << "[" << COL_GREEN << "info" << COL_CLEAR << " ] "
-#define ERROR std::cout << "[" << COL_RED << "error" << COL_CLEAR << "] "
-#define INPUT std::cout << "[" << COL_YELLOW << "input" << COL_CLEAR << "] "
+#define FAIL(message) \
+    do \
+    { \
+        std::stringstream __patos_failure; \
+        __patos_failure << message; \
+        throw PatosError(__patos_failure.str()); \
+    } while (0)
 
 #endif
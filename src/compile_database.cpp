@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sstream>
+
+#include "compile_database.h"
+#include "common.h"
+#include "file_handling.h"
+
+#include "boost/property_tree/ptree.hpp"
+#include "boost/property_tree/json_parser.hpp"
+#include "boost/program_options/parsers.hpp"
+
+// checks whether the current argument is the given flag and extracts its value
+// (either attached to the flag, e.g. '-Ifoo', or as the next argument, e.g. '-I foo')
+PRIVATE bool getFlagValue(const std::string &flag,
+                          std::vector<std::string>::const_iterator &it,
+                          const std::vector<std::string>::const_iterator &end,
+                          std::string &value)
+{
+    const std::string &argument = *it;
+
+    if (argument == flag)
+    {
+        if (std::next(it) == end)
+        {
+            return false;
+        }
+
+        ++it;
+        value = *it;
+        return true;
+    }
+
+    if (argument.compare(0, flag.size(), flag) == 0)
+    {
+        value = argument.substr(flag.size());
+        return true;
+    }
+
+    return false;
+}
+
+PRIVATE void parseFlags(const std::vector<std::string> &arguments, const std::string &directory, CompileCommand &command)
+{
+    for (auto it = arguments.begin(); it != arguments.end(); ++it)
+    {
+        std::string value;
+
+        if (getFlagValue("-isystem", it, arguments.end(), value))
+        {
+            if (!isAbsolutePath(value))
+            {
+                value = concatPaths(directory, value);
+            }
+
+            command.IncludePaths.push_back(IncludePath(value, clang::SrcMgr::CharacteristicKind::C_System));
+        }
+        else if (getFlagValue("-iquote", it, arguments.end(), value) || getFlagValue("-I", it, arguments.end(), value))
+        {
+            if (!isAbsolutePath(value))
+            {
+                value = concatPaths(directory, value);
+            }
+
+            // NOTE: user include paths must not be system paths, since declarations
+            // in system files are not transformed
+            command.IncludePaths.push_back(IncludePath(value, clang::SrcMgr::CharacteristicKind::C_User));
+        }
+        else if (getFlagValue("-D", it, arguments.end(), value))
+        {
+            command.Macros.push_back(MacroDefinition(value, false));
+        }
+        else if (getFlagValue("-U", it, arguments.end(), value))
+        {
+            command.Macros.push_back(MacroDefinition(value, true));
+        }
+    }
+}
+
+bool readCompileDatabase(const std::string &fileName, const std::string &inputDirectory, std::vector<CompileCommand> &result)
+{
+    namespace pt = boost::property_tree;
+
+    pt::ptree database;
+    try
+    {
+        pt::read_json(fileName, database);
+    }
+    catch (pt::json_parser_error const & ex)
+    {
+        ERROR << "unable to read compilation database: " << ex.what() << std::endl;
+        return false;
+    }
+
+    for (auto itEntry = database.begin(); itEntry != database.end(); ++itEntry)
+    {
+        const pt::ptree &entry = itEntry->second;
+
+        std::string directory = entry.get<std::string>("directory", ".");
+        std::string file = entry.get<std::string>("file", "");
+
+        if (file.empty())
+        {
+            ERROR << "entry without file in compilation database " << fileName << std::endl;
+            return false;
+        }
+
+        // get the command line of the entry
+        std::vector<std::string> arguments;
+        if (entry.count("arguments") > 0)
+        {
+            const pt::ptree &argumentList = entry.get_child("arguments");
+            for (auto itArgument = argumentList.begin(); itArgument != argumentList.end(); ++itArgument)
+            {
+                arguments.push_back(itArgument->second.get_value<std::string>());
+            }
+        }
+        else
+        {
+            arguments = boost::program_options::split_unix(entry.get<std::string>("command", ""));
+        }
+
+        CompileCommand command;
+
+        // files are translated in the output directory
+        // -> we need their location relative to the input directory
+        std::string absoluteFile = isAbsolutePath(file) ? file : concatPaths(directory, file);
+        command.File = getRelativePath(inputDirectory, absoluteFile);
+
+        if (isAbsolutePath(command.File))
+        {
+            ERROR << "file '" << absoluteFile << "' from compilation database is not inside the input directory" << std::endl;
+            return false;
+        }
+
+        parseFlags(arguments, directory, command);
+
+        result.push_back(command);
+    }
+
+    return true;
+}
+
+std::string getCompileFlagsKey(const CompileCommand &command)
+{
+    std::stringstream key;
+
+    for (auto it = command.IncludePaths.begin(); it != command.IncludePaths.end(); ++it)
+    {
+        key << (it->second == clang::SrcMgr::CharacteristicKind::C_System ? "S" : "U") << it->first << '\n';
+    }
+
+    for (auto it = command.Macros.begin(); it != command.Macros.end(); ++it)
+    {
+        key << (it->second ? "U" : "D") << it->first << '\n';
+    }
+
+    return key.str();
+}
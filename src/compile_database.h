@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_COMPILE_DATABASE_H
+#define __INCLUDE_COMPILE_DATABASE_H
+
+#include <string>
+#include <vector>
+
+#include "parse.h"
+
+struct CompileCommand
+{
+    // file to translate (relative to the input directory)
+    std::string File;
+
+    std::vector<IncludePath> IncludePaths;
+    std::vector<MacroDefinition> Macros;
+};
+
+/**
+ * Reads a compilation database in the format of clang's compile_commands.json
+ * (a JSON array of objects with the keys "directory", "file" and either "command"
+ * or "arguments"). Include paths (-I, -iquote, -isystem) and macro definitions
+ * (-D, -U) are extracted from the command of each entry; all other flags are ignored.
+ * Every listed file has to reside inside the input directory.
+ *
+ * @param fileName Path to the compilation database
+ * @param inputDirectory Input directory the listed files are made relative to
+ * @param result Vector the parsed entries are appended to (in the order of the database)
+ *
+ * @return True, if the database could be read, false otherwise.
+ */
+bool readCompileDatabase(const std::string &fileName, const std::string &inputDirectory, std::vector<CompileCommand> &result);
+
+/**
+ * Returns a string identifying the flags of a compile command, i.e. two commands
+ * with the same key are parsed exactly the same way.
+ */
+std::string getCompileFlagsKey(const CompileCommand &command);
+
+#endif
@@ -17,8 +17,6 @@
 #ifndef __INCLUDE_CONFIG_H
 #define __INCLUDE_CONFIG_H
 
-#define DEBUG_MODE
-
 //#define PASS_SANITIZE
 
 #endif
@@ -20,16 +20,23 @@
 #include <set>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <map>
 
 #include "driver.h"
 #include "config.h"
 #include "common.h"
 #include "file_handling.h"
 #include "parse.h"
+#include "compile_database.h"
+#include "translation_results.h"
+#include "instantiation_list.h"
 
 #include "pass_transformation.h"
 #include "pass_remove_templates.h"
 #include "pass_sanitize.h"
+#include "pass_scan_launches.h"
+#include "pass_resolve_instantiations.h"
 
 #include "clang/Basic/SourceManager.h"
 
@@ -37,6 +44,22 @@
 //====== DRIVER ======//
 
 
+struct TranslationFailure
+{
+    std::string Phase;
+    std::string FileName;
+    std::string Message;
+};
+
+// keep-going mode: output of the previous run for every file (by absolute path)
+// and the failures that occurred so far
+PRIVATE std::map<std::string, std::string> previousOutputs;
+PRIVATE std::vector<TranslationFailure> translationFailures;
+
+// information gathered by the transformation pass for all files (used for reports)
+PRIVATE TranslationResults translationResults;
+
+
 PRIVATE void createIncludePaths(std::vector<std::string> &paths, std::vector<IncludePath> &result)
 {
     for (auto it = paths.begin(); it != paths.end(); ++it)
@@ -45,8 +68,34 @@ PRIVATE void createIncludePaths(std::vector<std::string> &paths, std::vector<Inc
     }
 }
 
+PRIVATE void savePreviousOutputs(const struct Arguments &arguments)
+{
+    std::vector<std::string> files;
+    if (!(findAllFilesRecursively(arguments.InputDirectory, files)))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    for (auto it = files.begin(); it != files.end(); ++it)
+    {
+        std::string outputFile = getAbsolutePath(arguments.OutputDirectory, *it, "");
+        std::string content;
+
+        if (fileExists(outputFile) && readFile(outputFile, content))
+        {
+            previousOutputs[outputFile] = content;
+        }
+    }
+}
+
 PRIVATE void copyInputToOutput(const struct Arguments &arguments)
 {
+    // remember the last good output, so that we can restore it for files that fail to translate
+    if (arguments.KeepGoing)
+    {
+        savePreviousOutputs(arguments);
+    }
+
     if (!(copyDirectory(arguments.InputDirectory, arguments.OutputDirectory)))
     {
         ERROR << "unable to copy content of input directory to output directory" << std::endl;
@@ -60,38 +109,101 @@ PRIVATE void gatherInputFiles(const struct Arguments &arguments, std::vector<std
     {
         exit(EXIT_FAILURE);
     }
+
+    // the order of directory entries is unspecified, but the order in which files are
+    // transformed decides where specializations are emitted
+    // -> process files in a canonical order
+    std::sort(result.begin(), result.end());
+}
+
+PRIVATE bool checkPassResult(const struct Arguments &arguments,
+                             const std::string &phase,
+                             const std::string &absolutePath,
+                             const PatosConsumer &consumer,
+                             bool removeIfNew)
+{
+    if (!consumer.hasFailed())
+    {
+        return true;
+    }
+
+    // NOTE: the error itself has already been reported by the pass
+    if (!arguments.KeepGoing)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    TranslationFailure failure;
+    failure.Phase = phase;
+    failure.FileName = getRelativePath(arguments.OutputDirectory, absolutePath);
+    failure.Message = consumer.getFailureMessage();
+    translationFailures.push_back(failure);
+
+    // a failed pass does not write any changes, but the file in the output directory
+    // is still the untranslated copy of the input
+    // -> reset it to its last good output
+    auto itPrevious = previousOutputs.find(absolutePath);
+    if (itPrevious != previousOutputs.end())
+    {
+        if (writeFile(absolutePath, itPrevious->second))
+        {
+            INFO << "Kept last good output of " << failure.FileName << std::endl;
+        }
+        else
+        {
+            ERROR << "unable to restore last good output of " << failure.FileName << std::endl;
+        }
+    }
+    else if (removeIfNew)
+    {
+        // no good output yet -> do not leave the untranslated copy behind
+        removeFile(absolutePath);
+    }
+
+    return false;
 }
 
 PRIVATE void passTransformation(struct Arguments &arguments,
                                 std::string &fileName,
                                 std::vector<IncludePath> &includePaths,
-                                std::set<std::string> &templateFiles)
+                                std::set<std::string> &templateFiles,
+                                const std::vector<MacroDefinition> &macros = std::vector<MacroDefinition>())
 {
     // get the absolute path for the current file
     std::string absolutePath = getAbsolutePath(arguments.OutputDirectory, fileName, "");
 
     // create a consumer/pass for the current file
-    PassTransformation passTransformation(fileName, arguments, templateFiles);
+    std::set<std::string> fileTemplateFiles;
+    PassTransformation passTransformation(fileName, arguments, fileTemplateFiles, translationResults, macros);
 
     // parse the current file
-    parseAndConsume(absolutePath, passTransformation, includePaths, true, false);
+    parseAndConsume(absolutePath, passTransformation, includePaths, true, false, macros);
+
+    // only remember the template declarations of files that have been translated
+    if (checkPassResult(arguments, "transformation", absolutePath, passTransformation, true))
+    {
+        templateFiles.insert(fileTemplateFiles.begin(), fileTemplateFiles.end());
+    }
 }
 
 PRIVATE void passRemoveTemplates(struct Arguments &arguments,
                                  const std::string &fileName,
-                                 std::vector<IncludePath> &includePaths)
+                                 std::vector<IncludePath> &includePaths,
+                                 const std::vector<MacroDefinition> &macros = std::vector<MacroDefinition>())
 {
     // create a consumer/pass for the current file
     PassRemoveTemplates passRemoveTemplates(fileName, arguments);
 
     // parse the current file
-    parseAndConsume(fileName, passRemoveTemplates, includePaths, true, false);
+    parseAndConsume(fileName, passRemoveTemplates, includePaths, true, false, macros);
+
+    // NOTE: headers are not removed if they fail, since other (translated) files include them
+    checkPassResult(arguments, "remove-templates", fileName, passRemoveTemplates, false);
 }
 
-PRIVATE std::string appendExplicitInstantiation(const std::string &fileName,
-                                         const std::string &kernelName,
-                                         std::vector<std::string> &templateArguments,
-                                         std::vector<std::string> &argumentTypes)
+PRIVATE std::string createExplicitInstantiation(const std::string &kernelName,
+                                               const std::vector<std::string> &templateArguments,
+                                               const std::vector<std::string> &argumentTypes)
 {
     // create source for explicit specialization
     std::stringstream strInstantiation;
@@ -128,19 +240,35 @@ PRIVATE std::string appendExplicitInstantiation(const std::string &fileName,
         }
 
         strInstantiation << ");";
-
-        DBG << "explicit instantiation: " << strInstantiation.str() << std::endl;
     }
 
+    return strInstantiation.str();
+}
+
+PRIVATE std::string appendExplicitInstantiation(const std::string &fileName,
+                                         const std::string &kernelName,
+                                         const std::vector<std::string> &templateArguments,
+                                         const std::vector<std::string> &argumentTypes)
+{
+    std::string explicitInstantiation = createExplicitInstantiation(kernelName, templateArguments, argumentTypes);
+
+    DBG << "explicit instantiation: " << explicitInstantiation << std::endl;
+
     std::ofstream kernelFile(fileName, std::ofstream::out | std::ofstream::app);
-    kernelFile << strInstantiation.str() << std::endl;
+    kernelFile << explicitInstantiation << std::endl;
     kernelFile.close();
 
-    return strInstantiation.str();
+    return explicitInstantiation;
 }
 
 PRIVATE void removeExplicitInstantiation(const std::string &fileName, const std::string &explicitInstantiation)
 {
+    // the kernel file may have been removed if its translation failed (keep-going mode)
+    if (!fileExists(fileName))
+    {
+        return;
+    }
+
     std::vector<std::string> lines;
 
     // read lines from kernel file
@@ -192,7 +320,7 @@ void runTransformation(struct Arguments &arguments)
     gatherInputFiles(arguments, files);
 
     // some debugging output
-    #ifdef DEBUG_MODE
+    if (PatosLog::isEnabled(PatosLog::LEVEL_DEBUG))
     {
         for (auto it = files.begin(); it != files.end(); ++it)
         {
@@ -200,7 +328,6 @@ void runTransformation(struct Arguments &arguments)
             DBG << "   absolute: " << getAbsolutePath(*it, "", "") << std::endl;
         }
     }
-    #endif
 
     // this set will contain all files that contain template declarations
     // which have not beed removed yet
@@ -217,7 +344,6 @@ void runTransformation(struct Arguments &arguments)
     // which have not been removed yet
     for (auto it = templateFiles.begin(); it != templateFiles.end(); ++it)
     {
-        // NOTE: filenames in templateFiles are already absolute paths
         passRemoveTemplates(arguments, *it, includePaths);
     }
 
@@ -241,13 +367,193 @@ void runTransformation(struct Arguments &arguments)
     #endif
 }
 
-std::string instantiateKernel(
-                    struct Arguments &arguments,
-                    const std::string &kernelFile,
-                    const std::string &kernelName,
-                    std::vector<std::string> &templateArguments,
-                    std::vector<std::string> &argumentTypes
-                    )
+void runTransformationForCompileDatabase(struct Arguments &arguments)
+{
+    // read compilation database
+    std::vector<CompileCommand> commands;
+    if (!readCompileDatabase(arguments.CompileDatabaseFile, arguments.InputDirectory, commands))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    // copy content of input directory to output directory
+    // this is neccessary, because we only want to work on copies
+    copyInputToOutput(arguments);
+
+    // group entries by their flags, so that the lists of include paths and macros are only built once
+    // for all files sharing them (groups keep the order of the database)
+    // NOTE: no parsed state is shared, every file is still parsed and transformed on its own
+    struct CompileGroup
+    {
+        std::vector<IncludePath> IncludePaths;
+        std::vector<MacroDefinition> Macros;
+        std::vector<std::string> Files;
+    };
+
+    std::vector<CompileGroup> groups;
+    std::map<std::string, std::string> fileFlags;
+    {
+        std::map<std::string, unsigned> groupIndices;
+
+        for (auto it = commands.begin(); it != commands.end(); ++it)
+        {
+            std::string key = getCompileFlagsKey(*it);
+
+            // every file is transformed in place, i.e. it can only be translated once
+            auto itFile = fileFlags.find(it->File);
+            if (itFile != fileFlags.end())
+            {
+                if (itFile->second != key)
+                {
+                    ERROR << "file '" << it->File << "' is listed with different flags in the compilation database" << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                DBG << "skipping duplicate entry for " << it->File << std::endl;
+                continue;
+            }
+            fileFlags[it->File] = key;
+
+            auto itGroup = groupIndices.find(key);
+            if (itGroup == groupIndices.end())
+            {
+                CompileGroup group;
+
+                // system include paths from the command line come first
+                createIncludePaths(arguments.SystemIncludePaths, group.IncludePaths);
+                group.IncludePaths.insert(group.IncludePaths.end(), it->IncludePaths.begin(), it->IncludePaths.end());
+                group.Macros = it->Macros;
+
+                itGroup = groupIndices.insert(std::make_pair(key, groups.size())).first;
+                groups.push_back(group);
+            }
+
+            groups[itGroup->second].Files.push_back(it->File);
+        }
+    }
+
+    INFO << "Translating " << fileFlags.size() << " file(s) with " << groups.size() << " distinct set(s) of flags" << std::endl;
+
+    // files that contain template declarations which have not been removed yet,
+    // along with the group whose flags are used to parse them again
+    std::vector<std::string> templateFiles;
+    std::map<std::string, unsigned> templateFileGroups;
+
+    for (unsigned groupIdx = 0; groupIdx < groups.size(); ++groupIdx)
+    {
+        CompileGroup &group = groups[groupIdx];
+
+        std::set<std::string> groupTemplateFiles;
+        for (auto it = group.Files.begin(); it != group.Files.end(); ++it)
+        {
+            passTransformation(arguments, *it, group.IncludePaths, groupTemplateFiles, group.Macros);
+        }
+
+        for (auto it = groupTemplateFiles.begin(); it != groupTemplateFiles.end(); ++it)
+        {
+            if (templateFileGroups.insert(std::make_pair(*it, groupIdx)).second)
+            {
+                templateFiles.push_back(*it);
+            }
+        }
+    }
+
+    // template declarations may only be removed after all groups have been transformed,
+    // since files of later groups may include the same headers
+    for (auto it = templateFiles.begin(); it != templateFiles.end(); ++it)
+    {
+        CompileGroup &group = groups[templateFileGroups[*it]];
+        passRemoveTemplates(arguments, *it, group.IncludePaths, group.Macros);
+    }
+}
+
+bool scanHostLaunches(struct Arguments &arguments, std::vector<KernelInstantiation> &result)
+{
+    // host sources may include the kernel headers
+    std::vector<IncludePath> includePaths;
+    createIncludePaths(arguments.SystemIncludePaths, includePaths);
+    includePaths.push_back(IncludePath(arguments.HostDirectory, clang::SrcMgr::CharacteristicKind::C_User));
+    includePaths.push_back(IncludePath(arguments.InputDirectory, clang::SrcMgr::CharacteristicKind::C_User));
+
+    std::vector<std::string> files;
+    for (const char *suffix : {".cpp", ".cc", ".cxx"})
+    {
+        if (!findFilesRecursively(arguments.HostDirectory, suffix, files))
+        {
+            return false;
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    for (auto it = files.begin(); it != files.end(); ++it)
+    {
+        std::string absolutePath = getAbsolutePath(arguments.HostDirectory, *it, "");
+
+        std::vector<KernelInstantiation> fileInstantiations;
+        PassScanLaunches passScanLaunches(*it, arguments, fileInstantiations);
+
+        parseAndConsume(absolutePath, passScanLaunches, includePaths, true, false);
+
+        // NOTE: host files are never changed, so there is nothing to restore if the scan fails
+        if (checkPassResult(arguments, "scan-launches", absolutePath, passScanLaunches, false))
+        {
+            for (auto itInstantiation = fileInstantiations.begin(); itInstantiation != fileInstantiations.end(); ++itInstantiation)
+            {
+                addInstantiation(result, *itInstantiation);
+            }
+        }
+    }
+
+    INFO << "Found " << result.size() << " kernel instantiation(s) in " << files.size() << " host file(s)" << std::endl;
+
+    return true;
+}
+
+// gets the mangled names of kernel instantiations that are not generated now, by parsing their files
+// with the explicit instantiations appended (the spellings of the template arguments may use typedefs,
+// whereas the mangled names of the translation are derived from the canonical types)
+PRIVATE void resolveKernelNames(struct Arguments &arguments, std::vector<IncludePath> &includePaths, std::vector<KernelInstantiation> &instantiations)
+{
+    std::map<std::string, std::vector<std::string>> explicitInstantiations;
+    for (auto it = instantiations.begin(); it != instantiations.end(); ++it)
+    {
+        std::string kernelFileAbsolute = getAbsolutePath(arguments.OutputDirectory, it->KernelFile, "");
+        if (!fileExists(kernelFileAbsolute))
+        {
+            ERROR << "kernel file does not exist: " << it->KernelFile << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        explicitInstantiations[kernelFileAbsolute].push_back(appendExplicitInstantiation(kernelFileAbsolute, it->KernelName, it->TemplateArguments, it->ArgumentTypes));
+    }
+
+    std::map<std::string, std::string> mangledNames;
+    for (auto it = explicitInstantiations.begin(); it != explicitInstantiations.end(); ++it)
+    {
+        PassResolveInstantiations passResolveInstantiations(it->first, arguments, mangledNames);
+        parseAndConsume(it->first, passResolveInstantiations, includePaths, true, false);
+
+        for (auto itInstantiation = it->second.begin(); itInstantiation != it->second.end(); ++itInstantiation)
+        {
+            removeExplicitInstantiation(it->first, *itInstantiation);
+        }
+    }
+
+    for (auto it = instantiations.begin(); it != instantiations.end(); ++it)
+    {
+        auto itName = mangledNames.find(createExplicitInstantiation(it->KernelName, it->TemplateArguments, it->ArgumentTypes));
+        if (itName == mangledNames.end())
+        {
+            ERROR << "unable to resolve the name of kernel instantiation " << getInstantiationKey(*it) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        it->MangledName = itName->second;
+    }
+}
+
+void instantiateKernels(struct Arguments &arguments, const std::vector<KernelInstantiation> &instantiations,
+                        std::vector<KernelInstantiation> *deferredInstantiations)
 {
     // create list of include paths
     std::vector<IncludePath> includePaths;
@@ -257,16 +563,28 @@ std::string instantiateKernel(
     // this is neccessary, because we only want to work on copies
     copyInputToOutput(arguments);
 
-    // check if kernel file exists
-    std::string kernelFileAbsolute = getAbsolutePath(arguments.OutputDirectory, kernelFile, "");
-    if (!fileExists(kernelFileAbsolute))
+    // the deferred instantiations are not generated, only their names are required
+    if (deferredInstantiations != NULL)
     {
-        ERROR << "kernel file does not exist" << std::endl;
-        exit(EXIT_FAILURE);
+        resolveKernelNames(arguments, includePaths, *deferredInstantiations);
     }
 
-    // append explicit instantiation of kernel to input file
-    std::string explicitInstantiation = appendExplicitInstantiation(kernelFileAbsolute, kernelName, templateArguments, argumentTypes);
+    // append explicit instantiations of kernels to their files
+    std::vector<std::pair<std::string, std::string>> explicitInstantiations;
+    for (auto it = instantiations.begin(); it != instantiations.end(); ++it)
+    {
+        // check if kernel file exists
+        std::string kernelFileAbsolute = getAbsolutePath(arguments.OutputDirectory, it->KernelFile, "");
+        if (!fileExists(kernelFileAbsolute))
+        {
+            ERROR << "kernel file does not exist: " << it->KernelFile << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        std::string explicitInstantiation = appendExplicitInstantiation(kernelFileAbsolute, it->KernelName, it->TemplateArguments, it->ArgumentTypes);
+
+        explicitInstantiations.push_back(std::make_pair(kernelFileAbsolute, explicitInstantiation));
+    }
 
     // get all input files (files ending with .m) in the output directory
     std::vector<std::string> files;
@@ -287,14 +605,90 @@ std::string instantiateKernel(
     // which have not been removed yet
     for (auto it = templateFiles.begin(); it != templateFiles.end(); ++it)
     {
-        // NOTE: filenames in templateFiles are already absolute paths
         passRemoveTemplates(arguments, *it, includePaths);
     }
 
-    // remove explicit instantiation from kernel file
-    removeExplicitInstantiation(kernelFileAbsolute, explicitInstantiation);
+    // remove explicit instantiations from kernel files
+    for (auto it = explicitInstantiations.begin(); it != explicitInstantiations.end(); ++it)
+    {
+        removeExplicitInstantiation(it->first, it->second);
+    }
+}
+
+std::string instantiateKernel(
+                    struct Arguments &arguments,
+                    const std::string &kernelFile,
+                    const std::string &kernelName,
+                    std::vector<std::string> &templateArguments,
+                    std::vector<std::string> &argumentTypes
+                    )
+{
+    KernelInstantiation instantiation;
+    instantiation.KernelFile = kernelFile;
+    instantiation.KernelName = kernelName;
+    instantiation.TemplateArguments = templateArguments;
+    instantiation.ArgumentTypes = argumentTypes;
+    instantiation.LaunchCount = 1;
+
+    instantiateKernels(arguments, std::vector<KernelInstantiation>(1, instantiation));
 
     // now we can get the (type-mangled) name of the kernel instantiation
-    std::string mangledName = PatosNameMangling::getMangledNameForKernel(kernelName, templateArguments);
+    // (from the translation, if possible, since only the translation knows the canonical types)
+    std::string mangledName;
+    if (!translationResults.getExplicitInstantiation(createExplicitInstantiation(kernelName, templateArguments, argumentTypes), mangledName))
+    {
+        mangledName = PatosNameMangling::getMangledNameForKernel(kernelName, templateArguments);
+    }
+
     return mangledName;
 }
+
+bool writeTranslationReports(const struct Arguments &arguments)
+{
+    if (arguments.WriteBloatReport)
+    {
+        if (!translationResults.writeBloatReport(arguments.BloatReportFile))
+        {
+            ERROR << "unable to write bloat report to '" << arguments.BloatReportFile << "'" << std::endl;
+            return false;
+        }
+
+        INFO << "Wrote template instantiation bloat report to " << arguments.BloatReportFile << std::endl;
+    }
+
+    if (arguments.WriteLayoutReport)
+    {
+        if (!translationResults.writeLayoutReport(arguments.LayoutReportFile))
+        {
+            ERROR << "unable to write layout report to '" << arguments.LayoutReportFile << "'" << std::endl;
+            return false;
+        }
+
+        INFO << "Wrote record layout report to " << arguments.LayoutReportFile << std::endl;
+    }
+
+    return true;
+}
+
+bool reportTranslationFailures()
+{
+    if (translationFailures.empty())
+    {
+        return false;
+    }
+
+    ERROR << translationFailures.size() << " file(s) could not be translated" << std::endl;
+    PatosLog::flush();
+
+    // machine-readable summary: one line per failure, fields separated by tabs
+    for (auto it = translationFailures.begin(); it != translationFailures.end(); ++it)
+    {
+        std::string message = it->Message;
+        std::replace(message.begin(), message.end(), '\t', ' ');
+        std::replace(message.begin(), message.end(), '\n', ' ');
+
+        std::cout << "patos-failure\t" << it->Phase << "\t" << it->FileName << "\t" << message << std::endl;
+    }
+
+    return true;
+}
@@ -21,9 +21,30 @@
 #include <vector>
 
 #include "commandline.h"
+#include "instantiation_list.h"
 
 void runTransformation(struct Arguments &arguments);
 
+void runTransformationForCompileDatabase(struct Arguments &arguments);
+
+/**
+ * Scans the host sources (*.cpp, *.cc, *.cxx in the host directory) for launches
+ * of kernel templates through typed launch wrappers (see PassScanLaunches).
+ *
+ * @param result Vector the found instantiations are added to (duplicates are merged)
+ *
+ * @return True, if the host directory could be scanned, false otherwise.
+ */
+bool scanHostLaunches(struct Arguments &arguments, std::vector<KernelInstantiation> &result);
+
+/**
+ * Runs the transformation with explicit instantiations of the given kernels
+ * (all of them in one run). The deferred instantiations, if given, are not
+ * generated, but their mangled names are resolved (see KernelInstantiation::MangledName).
+ */
+void instantiateKernels(struct Arguments &arguments, const std::vector<KernelInstantiation> &instantiations,
+                        std::vector<KernelInstantiation> *deferredInstantiations = NULL);
+
 std::string instantiateKernel(
                     struct Arguments &arguments,
                     const std::string &kernelFile,
@@ -32,4 +53,18 @@ std::string instantiateKernel(
                     std::vector<std::string> &argumentTypes
                     );
 
+/**
+ * Writes the reports requested on the command line (e.g. the template instantiation bloat report).
+ *
+ * @return True, if all reports could be written, false otherwise.
+ */
+bool writeTranslationReports(const struct Arguments &arguments);
+
+/**
+ * Prints a summary of all files that could not be translated (keep-going mode).
+ *
+ * @return True, if the translation of at least one file failed, false otherwise.
+ */
+bool reportTranslationFailures();
+
 #endif
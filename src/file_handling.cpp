@@ -14,6 +14,9 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <fstream>
+#include <sstream>
+
 #include "file_handling.h"
 
 #include "common.h"
@@ -45,7 +48,58 @@ std::string getAbsolutePath(const std::string & directory, const std::string & f
     return fs::absolute(path).native();
 }
 
-PRIVATE void findFilesRecursively_Helper(boost::filesystem::path const & directory, const std::string & prefix, const std::string & suffix, std::vector<std::string> & result)
+PRIVATE boost::filesystem::path withoutDotComponents(boost::filesystem::path const & path)
+{
+    namespace fs = boost::filesystem;
+
+    // trailing separators show up as '.' components -> drop them
+    fs::path result;
+    for (auto it = path.begin(); it != path.end(); ++it)
+    {
+        if (*it != ".")
+        {
+            result /= *it;
+        }
+    }
+
+    return result;
+}
+
+std::string getRelativePath(const std::string & directory, const std::string & path)
+{
+    namespace fs = boost::filesystem;
+
+    fs::path directoryPath(withoutDotComponents(fs::absolute(directory)));
+    fs::path filePath(withoutDotComponents(fs::absolute(path)));
+
+    // check whether the directory is a prefix of the path
+    auto itFile = filePath.begin();
+    for (auto itDirectory = directoryPath.begin(); itDirectory != directoryPath.end(); ++itDirectory, ++itFile)
+    {
+        if (itFile == filePath.end() || *itDirectory != *itFile)
+        {
+            // path is not inside the directory -> leave it untouched
+            return path;
+        }
+    }
+
+    fs::path result;
+    for (; itFile != filePath.end(); ++itFile)
+    {
+        result /= *itFile;
+    }
+
+    return result.native();
+}
+
+bool isAbsolutePath(const std::string & path)
+{
+    namespace fs = boost::filesystem;
+
+    return fs::path(path).is_absolute();
+}
+
+PRIVATE void findFilesRecursively_Helper(boost::filesystem::path const & directory, const std::string & prefix, const std::string & suffix, bool anySuffix, std::vector<std::string> & result)
 {
     namespace fs = boost::filesystem;
 
@@ -55,11 +109,11 @@ PRIVATE void findFilesRecursively_Helper(boost::filesystem::path const & directo
 
         if (fs::is_directory(current))
         {
-            findFilesRecursively_Helper(current, prefix + current.filename().string() + fs::path("/").native(), suffix, result);
+            findFilesRecursively_Helper(current, prefix + current.filename().string() + fs::path("/").native(), suffix, anySuffix, result);
         }
         else
         {
-            if (current.extension() == suffix)
+            if (anySuffix || current.extension() == suffix)
             {
                 // found a file we were looking for
                 result.push_back(prefix + current.filename().string());
@@ -80,7 +134,23 @@ bool findFilesRecursively(const std::string & directoryName, const std::string &
         return false;
     }
 
-    findFilesRecursively_Helper(directory, "", suffix, result);
+    findFilesRecursively_Helper(directory, "", suffix, false, result);
+    return true;
+}
+
+bool findAllFilesRecursively(const std::string & directoryName, std::vector<std::string> & result)
+{
+    namespace fs = boost::filesystem;
+
+    fs::path directory(directoryName);
+
+    if (!(fs::exists(directory) && fs::is_directory(directory)))
+    {
+        ERROR << "directory '" << directoryName << "' does not exist" << std::endl;
+        return false;
+    }
+
+    findFilesRecursively_Helper(directory, "", "", true, result);
     return true;
 }
 
@@ -124,6 +194,50 @@ bool makeDirectories(const std::string & path)
     }
 }
 
+bool readFile(const std::string &fileName, std::string &content)
+{
+    std::ifstream file(fileName, std::ifstream::in | std::ifstream::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    std::stringstream strstr;
+    strstr << file.rdbuf();
+    content = strstr.str();
+
+    return true;
+}
+
+bool writeFile(const std::string &fileName, const std::string &content)
+{
+    std::ofstream file(fileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    file << content;
+    return file.good();
+}
+
+bool removeFile(const std::string &fileName)
+{
+    namespace fs = boost::filesystem;
+
+    try
+    {
+        return fs::remove(fs::path(fileName));
+    }
+    catch (fs::filesystem_error const & ex)
+    {
+        ERROR << ex.what() << std::endl;
+        return false;
+    }
+}
+
 PRIVATE bool copyDirectory_Helper(boost::filesystem::path const & sourcePath, boost::filesystem::path const & destinationPath)
 {
     namespace fs = boost::filesystem;
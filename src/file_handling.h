@@ -24,13 +24,22 @@ std::string concatPaths(const std::string & path1, const std::string & path2);
 
 std::string getAbsolutePath(const std::string & directory, const std::string & filename, const std::string & extension);
 
+std::string getRelativePath(const std::string & directory, const std::string & path);
+
+bool isAbsolutePath(const std::string & path);
+
 bool findFilesRecursively(const std::string &directoryName, const std::string &suffix, std::vector<std::string> &result);
+bool findAllFilesRecursively(const std::string &directoryName, std::vector<std::string> &result);
 
 bool directoryExists(const std::string & path);
 bool fileExists(const std::string &fileName);
 
 bool makeDirectories(const std::string & path);
 
+bool readFile(const std::string &fileName, std::string &content);
+bool writeFile(const std::string &fileName, const std::string &content);
+bool removeFile(const std::string &fileName);
+
 bool copyDirectory(const std::string & source, const std::string & destination);
 
 std::string stripFileName(const std::string & path);
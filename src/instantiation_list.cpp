@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <sstream>
+
+#include "instantiation_list.h"
+#include "common.h"
+#include "file_handling.h"
+
+#define INSTANTIATION_LIST_FIELD_SEPARATOR '\t'
+#define INSTANTIATION_LIST_VALUE_SEPARATOR ';'
+
+PRIVATE std::string joinValues(const std::vector<std::string> &values)
+{
+    std::stringstream result;
+
+    for (auto it = values.begin(); it != values.end(); ++it)
+    {
+        if (it != values.begin())
+        {
+            result << INSTANTIATION_LIST_VALUE_SEPARATOR;
+        }
+
+        result << *it;
+    }
+
+    return result.str();
+}
+
+PRIVATE std::vector<std::string> splitString(const std::string &value, char separator)
+{
+    std::vector<std::string> result;
+
+    std::string::size_type begin = 0;
+    while (true)
+    {
+        std::string::size_type end = value.find(separator, begin);
+        result.push_back(value.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+
+        if (end == std::string::npos)
+        {
+            break;
+        }
+
+        begin = end + 1;
+    }
+
+    return result;
+}
+
+PRIVATE bool isIdentifierCharacter(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// the runtime and the host scanner may spell types differently (e.g. 'Foo<int >' and 'Foo<int>')
+// -> only keep whitespace that separates two words
+PRIVATE std::string normalizeSpelling(const std::string &value)
+{
+    std::string result;
+
+    for (unsigned idx = 0; idx < value.size(); ++idx)
+    {
+        if (!std::isspace(static_cast<unsigned char>(value[idx])))
+        {
+            result += value[idx];
+            continue;
+        }
+
+        unsigned next = idx;
+        while (next < value.size() && std::isspace(static_cast<unsigned char>(value[next])))
+        {
+            ++next;
+        }
+
+        if (!result.empty() && next < value.size() && isIdentifierCharacter(result[result.size()-1]) && isIdentifierCharacter(value[next]))
+        {
+            result += ' ';
+        }
+
+        idx = next - 1;
+    }
+
+    return result;
+}
+
+PRIVATE std::string getUsageKey(const std::string &kernelName, const std::vector<std::string> &templateArguments)
+{
+    std::vector<std::string> normalizedArguments;
+    for (auto it = templateArguments.begin(); it != templateArguments.end(); ++it)
+    {
+        normalizedArguments.push_back(normalizeSpelling(*it));
+    }
+
+    return kernelName + INSTANTIATION_LIST_FIELD_SEPARATOR + joinValues(normalizedArguments);
+}
+
+std::string getInstantiationKey(const KernelInstantiation &instantiation)
+{
+    std::stringstream key;
+
+    key << instantiation.KernelFile << INSTANTIATION_LIST_FIELD_SEPARATOR
+        << instantiation.KernelName << INSTANTIATION_LIST_FIELD_SEPARATOR
+        << joinValues(instantiation.TemplateArguments) << INSTANTIATION_LIST_FIELD_SEPARATOR
+        << joinValues(instantiation.ArgumentTypes);
+
+    return key.str();
+}
+
+void addInstantiation(std::vector<KernelInstantiation> &list, const KernelInstantiation &instantiation)
+{
+    std::string key = getInstantiationKey(instantiation);
+
+    for (auto it = list.begin(); it != list.end(); ++it)
+    {
+        if (getInstantiationKey(*it) == key)
+        {
+            it->LaunchCount += instantiation.LaunchCount;
+            return;
+        }
+    }
+
+    list.push_back(instantiation);
+}
+
+bool readInstantiationList(const std::string &fileName, std::vector<KernelInstantiation> &result)
+{
+    std::string content;
+    if (!readFile(fileName, content))
+    {
+        ERROR << "unable to read instantiation list " << fileName << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> lines = splitString(content, '\n');
+    for (unsigned lineIdx = 0; lineIdx < lines.size(); ++lineIdx)
+    {
+        const std::string &line = lines[lineIdx];
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::vector<std::string> fields = splitString(line, INSTANTIATION_LIST_FIELD_SEPARATOR);
+        if (fields.size() < 5 || fields[1].empty() || fields[2].empty())
+        {
+            ERROR << fileName << ":" << (lineIdx + 1) << ": invalid instantiation" << std::endl;
+            return false;
+        }
+
+        KernelInstantiation instantiation;
+        try
+        {
+            instantiation.LaunchCount = std::stoul(fields[0]);
+        }
+        catch (std::logic_error const & ex)
+        {
+            ERROR << fileName << ":" << (lineIdx + 1) << ": invalid launch count '" << fields[0] << "'" << std::endl;
+            return false;
+        }
+
+        instantiation.KernelFile = fields[1];
+        instantiation.KernelName = fields[2];
+
+        if (!fields[3].empty())
+        {
+            instantiation.TemplateArguments = splitString(fields[3], INSTANTIATION_LIST_VALUE_SEPARATOR);
+        }
+
+        if (!fields[4].empty())
+        {
+            instantiation.ArgumentTypes = splitString(fields[4], INSTANTIATION_LIST_VALUE_SEPARATOR);
+        }
+
+        addInstantiation(result, instantiation);
+    }
+
+    return true;
+}
+
+bool writeInstantiationList(const std::string &fileName, const std::vector<KernelInstantiation> &list, bool withMangledNames)
+{
+    std::stringstream content;
+
+    content << "# launch count\tkernel file\tkernel\ttemplate arguments\targument types";
+    if (withMangledNames)
+    {
+        content << "\tmangled name";
+    }
+    content << std::endl;
+
+    for (auto it = list.begin(); it != list.end(); ++it)
+    {
+        content << it->LaunchCount << INSTANTIATION_LIST_FIELD_SEPARATOR
+                << getInstantiationKey(*it);
+
+        if (withMangledNames)
+        {
+            // NOTE: the name cannot be derived from the spellings of the template arguments, which may use typedefs
+            if (it->MangledName.empty())
+            {
+                ERROR << "the name of kernel instantiation " << getInstantiationKey(*it) << " has not been resolved" << std::endl;
+                return false;
+            }
+
+            content << INSTANTIATION_LIST_FIELD_SEPARATOR << it->MangledName;
+        }
+
+        content << std::endl;
+    }
+
+    return writeFile(fileName, content.str());
+}
+
+bool readUsageLog(const std::string &fileName, UsageCounts &result)
+{
+    std::string content;
+    if (!readFile(fileName, content))
+    {
+        ERROR << "unable to read usage log " << fileName << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> lines = splitString(content, '\n');
+    for (unsigned lineIdx = 0; lineIdx < lines.size(); ++lineIdx)
+    {
+        const std::string &line = lines[lineIdx];
+
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::vector<std::string> fields = splitString(line, INSTANTIATION_LIST_FIELD_SEPARATOR);
+        if (fields.size() < 3 || fields[1].empty())
+        {
+            ERROR << fileName << ":" << (lineIdx + 1) << ": invalid usage entry" << std::endl;
+            return false;
+        }
+
+        unsigned long launchCount;
+        try
+        {
+            launchCount = std::stoul(fields[0]);
+        }
+        catch (std::logic_error const & ex)
+        {
+            ERROR << fileName << ":" << (lineIdx + 1) << ": invalid launch count '" << fields[0] << "'" << std::endl;
+            return false;
+        }
+
+        std::vector<std::string> templateArguments;
+        if (!fields[2].empty())
+        {
+            templateArguments = splitString(fields[2], INSTANTIATION_LIST_VALUE_SEPARATOR);
+        }
+
+        result[getUsageKey(fields[1], templateArguments)] += launchCount;
+    }
+
+    return true;
+}
+
+void selectHotInstantiations(const std::vector<KernelInstantiation> &candidates,
+                             const UsageCounts &usage,
+                             unsigned long threshold,
+                             std::vector<KernelInstantiation> &hot,
+                             std::vector<KernelInstantiation> &cold)
+{
+    std::set<std::string> knownKeys;
+
+    for (auto it = candidates.begin(); it != candidates.end(); ++it)
+    {
+        std::string key = getUsageKey(it->KernelName, it->TemplateArguments);
+        knownKeys.insert(key);
+
+        KernelInstantiation instantiation = *it;
+
+        auto itUsage = usage.find(key);
+        instantiation.LaunchCount = (itUsage != usage.end()) ? itUsage->second : 0;
+
+        if (instantiation.LaunchCount >= threshold)
+        {
+            hot.push_back(instantiation);
+        }
+        else
+        {
+            cold.push_back(instantiation);
+        }
+    }
+
+    // without kernel file and argument types, we cannot instantiate kernels only known from the log
+    for (auto it = usage.begin(); it != usage.end(); ++it)
+    {
+        if (knownKeys.find(it->first) == knownKeys.end())
+        {
+            std::string description = it->first;
+            std::replace(description.begin(), description.end(), INSTANTIATION_LIST_FIELD_SEPARATOR, ' ');
+
+            INFO << "Ignoring unknown kernel instantiation from usage log: " << description << std::endl;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_INSTANTIATION_LIST_H
+#define __INCLUDE_INSTANTIATION_LIST_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct KernelInstantiation
+{
+    // file containing the kernel template (relative to the input directory)
+    std::string KernelFile;
+    std::string KernelName;
+
+    std::vector<std::string> TemplateArguments;
+    std::vector<std::string> ArgumentTypes;
+
+    // number of launch sites found for this instantiation
+    unsigned long LaunchCount;
+
+    // (type-mangled) name of the kernel instantiation, if it has been resolved
+    std::string MangledName;
+
+    KernelInstantiation():
+        LaunchCount(0)
+    {
+        /* intentionally left blank */
+    }
+};
+
+/**
+ * Returns a string identifying an instantiation, i.e. two instantiations
+ * with the same key result in the same explicit instantiation.
+ */
+std::string getInstantiationKey(const KernelInstantiation &instantiation);
+
+/**
+ * Adds an instantiation to a list. If the list already contains the instantiation,
+ * only its launch count is increased.
+ */
+void addInstantiation(std::vector<KernelInstantiation> &list, const KernelInstantiation &instantiation);
+
+/**
+ * Reads a list of kernel instantiations. Every line contains the fields
+ *
+ *    <launch count> <kernel file> <kernel name> <template arguments> <argument types>
+ *
+ * separated by tabs, where the template arguments and argument types are separated
+ * by semicolons. Empty lines and lines starting with '#' are ignored.
+ *
+ * @param fileName Path to the list
+ * @param result Vector the instantiations are added to (duplicates are merged)
+ *
+ * @return True, if the list could be read, false otherwise.
+ */
+bool readInstantiationList(const std::string &fileName, std::vector<KernelInstantiation> &result);
+
+/**
+ * Writes a list of kernel instantiations in the format read by readInstantiationList().
+ * If requested, the (type-mangled) name of each kernel instantiation is added as a sixth field
+ * (the names have to be resolved, see instantiateKernels()).
+ *
+ * @return True, if the list could be written, false otherwise.
+ */
+bool writeInstantiationList(const std::string &fileName, const std::vector<KernelInstantiation> &list, bool withMangledNames = false);
+
+// launch counts recorded by the runtime (by kernel name and template arguments)
+typedef std::map<std::string, unsigned long> UsageCounts;
+
+/**
+ * Reads a usage log recorded by the runtime. Every line contains the fields
+ *
+ *    <launch count> <kernel name> <template arguments>
+ *
+ * separated by tabs, where the template arguments are separated by semicolons.
+ * Counts of lines for the same instantiation are summed up. Empty lines and lines
+ * starting with '#' are ignored.
+ *
+ * @return True, if the log could be read, false otherwise.
+ */
+bool readUsageLog(const std::string &fileName, UsageCounts &result);
+
+/**
+ * Splits a list of instantiations by their launch counts in a usage log: instantiations
+ * launched at least 'threshold' times are hot, all others are cold. The launch count
+ * of each instantiation is replaced by the one from the log.
+ */
+void selectHotInstantiations(const std::vector<KernelInstantiation> &candidates,
+                             const UsageCounts &usage,
+                             unsigned long threshold,
+                             std::vector<KernelInstantiation> &hot,
+                             std::vector<KernelInstantiation> &cold);
+
+#endif
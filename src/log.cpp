@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <streambuf>
+
+#include "llvm/Support/Signals.h"
+
+#include "log.h"
+#include "common.h"
+
+#define LOG_BUFFER_SIZE (64 * 1024)
+
+PatosLog::Level PatosLog::currentLevel = PatosLog::LEVEL_INFO;
+
+class BufferedSink: public std::streambuf
+{
+private:
+    char buffer[LOG_BUFFER_SIZE];
+
+public:
+    BufferedSink()
+    {
+        this->setp(this->buffer, this->buffer + LOG_BUFFER_SIZE);
+    }
+
+    ~BufferedSink()
+    {
+        this->writeBuffer();
+    }
+
+    void writeBuffer()
+    {
+        ptrdiff_t size = this->pptr() - this->pbase();
+
+        if (size > 0)
+        {
+            fwrite(this->pbase(), 1, size, stdout);
+            fflush(stdout);
+        }
+
+        this->setp(this->buffer, this->buffer + LOG_BUFFER_SIZE);
+    }
+
+    // NOTE: only uses async-signal-safe functions
+    void writeBufferFromSignalHandler()
+    {
+        ptrdiff_t size = this->pptr() - this->pbase();
+
+        if (size > 0 && write(STDOUT_FILENO, this->pbase(), size) < 0)
+        {
+            // nothing left to do
+        }
+    }
+
+protected:
+    int overflow(int c)
+    {
+        this->writeBuffer();
+
+        if (c != traits_type::eof())
+        {
+            *this->pptr() = traits_type::to_char_type(c);
+            this->pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    int sync()
+    {
+        // intentionally left blank (see log.h)
+        return 0;
+    }
+};
+
+// NOTE: function-local statics, so that the sink can be used during static initialization
+// and is written to stdout when the program exits
+PRIVATE BufferedSink &getBuffer()
+{
+    static BufferedSink buffer;
+    return buffer;
+}
+
+PRIVATE void writeBufferOnCrash(void *)
+{
+    getBuffer().writeBufferFromSignalHandler();
+}
+
+void PatosLog::setLevel(Level level)
+{
+    PatosLog::currentLevel = level;
+}
+
+std::ostream &PatosLog::sink()
+{
+    static std::ostream stream(&getBuffer());
+    return stream;
+}
+
+void PatosLog::flush()
+{
+    getBuffer().writeBuffer();
+}
+
+void PatosLog::flushOnCrash()
+{
+    // NOTE: LLVM's signal handlers call it before printing the stack trace and terminating
+    llvm::sys::AddSignalHandler(writeBufferOnCrash, NULL);
+}
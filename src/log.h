@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_LOG_H
+#define __INCLUDE_LOG_H
+
+#include <ostream>
+
+// ========== LOGGING ==========
+
+namespace PatosLog
+{
+    enum Level
+    {
+        LEVEL_ERROR = 0,
+        LEVEL_INFO  = 1,
+        LEVEL_DEBUG = 2
+    };
+
+    extern Level currentLevel;
+
+    inline bool isEnabled(Level level)
+    {
+        return level <= currentLevel;
+    }
+
+    void setLevel(Level level);
+
+    // buffered stream all log messages (except for errors) are written to
+    // NOTE: flushing the stream (e.g. std::endl) does *not* write the buffer to stdout,
+    // this only happens if the buffer is full, on flush(), at exit and (after flushOnCrash()) on crashes
+    std::ostream &sink();
+
+    void flush();
+
+    // registers writing the buffer with the crash handlers of LLVM
+    void flushOnCrash();
+}
+
+#endif
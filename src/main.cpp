@@ -39,6 +39,19 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
+    // set log level
+    if (arguments.Verbose)
+    {
+        PatosLog::setLevel(PatosLog::LEVEL_DEBUG);
+    }
+    else if (arguments.Quiet)
+    {
+        PatosLog::setLevel(PatosLog::LEVEL_ERROR);
+    }
+
+    // do not lose the buffered log output if clang (or patos) crashes
+    PatosLog::flushOnCrash();
+
     // check whether specified directories exist
     {
         if (!directoryExists(arguments.InputDirectory))
@@ -78,6 +91,16 @@ int main(int argc, char **argv)
             INFO << "Dump ASTs to " << arguments.ASTDumpDirectory << std::endl;
         }
 
+        if (arguments.UseCompileDatabase)
+        {
+            INFO << "Using compilation database " << arguments.CompileDatabaseFile << std::endl;
+        }
+
+        if (arguments.ScanHostSources)
+        {
+            INFO << "Scanning host sources in " << arguments.HostDirectory << std::endl;
+        }
+
         if (arguments.SystemIncludePaths.empty())
         {
             INFO << "No include paths provided" << std::endl;
@@ -156,7 +179,81 @@ int main(int argc, char **argv)
         }
 
         // run the actual transformation and add explicit instantiation of kernel template
-        instantiateKernel(arguments, kernelFile, kernelName, templateArguments, argumentTypes);
+        std::string mangledName = instantiateKernel(arguments, kernelFile, kernelName, templateArguments, argumentTypes);
+
+        INFO << "Name of kernel instantiation: " << mangledName << std::endl;
+        PatosLog::flush();
+
+        // machine-readable result (also with --quiet), on a line of its own after the last prompt
+        std::cout << std::endl << "patos-kernel\t" << mangledName << std::endl;
+    }
+    else if (arguments.ScanHostSources || arguments.ReadInstantiationList)
+    {
+        // gather the kernel instantiations from the list and/or the host sources
+        std::vector<KernelInstantiation> instantiations;
+
+        if (arguments.ReadInstantiationList && !readInstantiationList(arguments.InstantiationListFile, instantiations))
+        {
+            return EXIT_FAILURE;
+        }
+
+        if (arguments.ScanHostSources && !scanHostLaunches(arguments, instantiations))
+        {
+            return EXIT_FAILURE;
+        }
+
+        if (arguments.WriteInstantiationList)
+        {
+            if (!writeInstantiationList(arguments.WrittenInstantiationListFile, instantiations))
+            {
+                ERROR << "unable to write instantiation list to '" << arguments.WrittenInstantiationListFile << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            INFO << "Wrote " << instantiations.size() << " kernel instantiation(s) to " << arguments.WrittenInstantiationListFile << std::endl;
+        }
+
+        // only generate the hot instantiations, the cold ones can be generated on demand later on
+        if (arguments.UseUsageLog)
+        {
+            UsageCounts usage;
+            if (!readUsageLog(arguments.UsageLogFile, usage))
+            {
+                return EXIT_FAILURE;
+            }
+
+            std::vector<KernelInstantiation> hotInstantiations;
+            std::vector<KernelInstantiation> coldInstantiations;
+            selectHotInstantiations(instantiations, usage, arguments.HotThreshold, hotInstantiations, coldInstantiations);
+
+            INFO << "Generating " << hotInstantiations.size() << " hot kernel instantiation(s), deferring "
+                 << coldInstantiations.size() << " cold one(s)" << std::endl;
+
+            // run the actual transformation with the hot instantiations at once
+            // (the names of the cold ones are resolved for the manifest)
+            instantiateKernels(arguments, hotInstantiations, arguments.WriteLazyManifest ? &coldInstantiations : NULL);
+
+            if (arguments.WriteLazyManifest)
+            {
+                if (!writeInstantiationList(arguments.LazyManifestFile, coldInstantiations, true))
+                {
+                    ERROR << "unable to write lazy manifest to '" << arguments.LazyManifestFile << "'" << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                INFO << "Wrote manifest of lazily generated kernel instantiations to " << arguments.LazyManifestFile << std::endl;
+            }
+        }
+        else
+        {
+            // run the actual transformation with all instantiations at once
+            instantiateKernels(arguments, instantiations);
+        }
+    }
+    else if (arguments.UseCompileDatabase)
+    {
+        // run the transformation for the files listed in the compilation database
+        runTransformationForCompileDatabase(arguments);
     }
     else
     {
@@ -164,5 +261,12 @@ int main(int argc, char **argv)
         runTransformation(arguments);
     }
 
+    bool reportsWritten = writeTranslationReports(arguments);
+
+    if (reportTranslationFailures() || !reportsWritten)
+    {
+        return EXIT_FAILURE;
+    }
+
     return 0;
 }
@@ -17,10 +17,14 @@
 #include <sstream>
 #include <map>
 #include <vector>
+#include <cctype>
 
 #include "name_mangling.h"
 #include "common.h"
 
+#include "clang/AST/PrettyPrinter.h"
+#include "clang/Basic/LangOptions.h"
+
 const std::string PatosNameMangling::MANGLED_NAME_FUNCTION_PREFIX = "__patos_";
 const std::string PatosNameMangling::MANGLED_NAME_RECORD_PREFIX = "__Patos_";
 const std::string PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER = "_";
@@ -29,26 +33,257 @@ const std::string PatosNameMangling::MANGLED_NAME_OPERATOR = "operator__";
 
 
 // ========== NAME MANGLING ========== 
+//
+// template arguments are encoded by their canonical type, so that every type yields exactly
+// one name (independent of typedefs and other sugar) and names are valid identifiers:
+//
+//    builtin types        compact spelling ('int', 'uint' for 'unsigned int', 'longlong', ...)
+//    records, enums       length-prefixed name ('10Comparator')
+//    specializations      length-prefixed name, arguments between 'I' and 'E' ('10ComparatorIintE')
+//    nested names         enclosing namespaces/records and the name between 'N' and 'E' ('N1a3FooE' for 'a::Foo',
+//                         'N1a3VecIintEE' for 'a::Vec<int>'), names in the global namespace are not nested
+//    pointers             'P' + pointee ('Pint' for 'int *')
+//    references           'R' (lvalue), 'O' (rvalue) + referenced type
+//    arrays               'A' + size + 'E' + element type ('A4Eint' for 'int[4]')
+//    qualifiers           'K' (const), 'V' (volatile) before the qualified type ('PKint' for 'const int *')
+//    vectors              OpenCL name ('float4', 'uint8')
+//    integral values      'L' + value + 'E', 'n' for negative values ('L16E', 'Ln1E'); also bools and enums
+//
+// multiple arguments are separated by MANGLED_NAME_TYPE_DELIMITER (encodings never contain it
+// outside of length-prefixed names)
+// NOTE: names of records/enums may contain it, i.e. the encoding cannot be split at the delimiter
 
-std::string PatosNameMangling::getMangledNameForFunction(const FunctionDecl *Declaration)
+PRIVATE std::string getLengthPrefixedName(const std::string &name)
+{
+    return std::to_string(name.size()) + name;
+}
+
+// 'unsigned int' -> 'uint', 'long long' -> 'longlong', 'wchar_t' -> 'wchar', '__int128' -> 'int128'
+PRIVATE std::string getCompactBuiltinName(const std::string &spelling)
+{
+    std::string name = spelling;
+
+    const std::string unsignedPrefix = "unsigned ";
+    if (name.compare(0, unsignedPrefix.size(), unsignedPrefix) == 0)
+    {
+        name = "u" + name.substr(unsignedPrefix.size());
+    }
+
+    if (name.size() > 2 && name.compare(name.size() - 2, 2, "_t") == 0)
+    {
+        name = name.substr(0, name.size() - 2);
+    }
+
+    std::string result;
+    for (char c : name)
+    {
+        if (c != ' ' && c != '_')
+        {
+            result += c;
+        }
+    }
+
+    return result;
+}
+
+// fallback for types without a dedicated encoding: replace all characters that are
+// not allowed in identifiers
+PRIVATE std::string getSanitizedName(const std::string &spelling)
+{
+    std::string result;
+    for (char c : spelling)
+    {
+        result += (std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+
+    return getLengthPrefixedName(result);
+}
+
+// '16' -> 'L16E', '-1' -> 'Ln1E'
+PRIVATE std::string getMangledNameForIntegralValue(const std::string &value)
+{
+    if (!value.empty() && value[0] == '-')
+    {
+        return "Ln" + value.substr(1) + "E";
+    }
+
+    return "L" + value + "E";
+}
+
+PRIVATE std::string getMangledNameForTemplateArguments(const TemplateArgumentList &templateArguments)
 {
     std::stringstream strstr;
 
-    if (isa<CXXMethodDecl>(Declaration))
+    for (unsigned i = 0; i < templateArguments.size(); ++i)
     {
-        const CXXRecordDecl *parent = cast<CXXMethodDecl>(Declaration)->getParent();
+        if (i > 0)
+        {
+            strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER;
+        }
 
-        strstr << PatosNameMangling::MANGLED_NAME_RECORD_PREFIX << parent->getNameAsString();
+        strstr << PatosNameMangling::getMangledNameForTemplateArgument(templateArguments.get(i));
+    }
 
-        if (isa<ClassTemplateSpecializationDecl>(parent))
+    return strstr.str();
+}
+
+// name of a record or enum qualified by its enclosing namespaces and records (see above),
+// the encoding of the name itself (including template arguments) is given
+PRIVATE std::string getNestedName(const Decl *Declaration, const std::string &name)
+{
+    std::string prefix;
+
+    for (const DeclContext *context = Declaration->getDeclContext(); !context->isTranslationUnit(); context = context->getParent())
+    {
+        if (isa<NamespaceDecl>(context))
+        {
+            const NamespaceDecl *namespaceDeclaration = cast<NamespaceDecl>(context);
+
+            prefix = getLengthPrefixedName(namespaceDeclaration->isAnonymousNamespace() ? "_GLOBAL__N" : namespaceDeclaration->getNameAsString()) + prefix;
+        }
+        else if (isa<RecordDecl>(context))
+        {
+            const RecordDecl *record = cast<RecordDecl>(context);
+
+            std::string component = getLengthPrefixedName(record->getNameAsString());
+            if (isa<ClassTemplateSpecializationDecl>(record))
+            {
+                component += "I" + getMangledNameForTemplateArguments(cast<ClassTemplateSpecializationDecl>(record)->getTemplateArgs()) + "E";
+            }
+
+            prefix = component + prefix;
+        }
+
+        // other contexts (e.g. 'extern "C"' or functions) do not contribute
+    }
+
+    return prefix.empty() ? name : "N" + prefix + name + "E";
+}
+
+std::string PatosNameMangling::getMangledNameForType(QualType type)
+{
+    std::stringstream strstr;
+
+    QualType canonicalType = type.getCanonicalType();
+
+    if (canonicalType.isConstQualified())
+    {
+        strstr << "K";
+    }
+
+    if (canonicalType.isVolatileQualified())
+    {
+        strstr << "V";
+    }
+
+    const Type *typePtr = canonicalType.getTypePtr();
+
+    if (isa<BuiltinType>(typePtr))
+    {
+        LangOptions languageOptions;
+        languageOptions.CPlusPlus = 1;
+        languageOptions.Bool = 1;
+
+        strstr << getCompactBuiltinName(cast<BuiltinType>(typePtr)->getName(PrintingPolicy(languageOptions)).str());
+    }
+    else if (isa<VectorType>(typePtr))
+    {
+        // element types are builtin types, whose compact names match the OpenCL names ('uint' for 'unsigned int')
+        const VectorType *vectorType = cast<VectorType>(typePtr);
+        strstr << getMangledNameForType(vectorType->getElementType()) << vectorType->getNumElements();
+    }
+    else if (isa<PointerType>(typePtr))
+    {
+        strstr << "P" << getMangledNameForType(cast<PointerType>(typePtr)->getPointeeType());
+    }
+    else if (isa<LValueReferenceType>(typePtr))
+    {
+        strstr << "R" << getMangledNameForType(cast<ReferenceType>(typePtr)->getPointeeType());
+    }
+    else if (isa<RValueReferenceType>(typePtr))
+    {
+        strstr << "O" << getMangledNameForType(cast<ReferenceType>(typePtr)->getPointeeType());
+    }
+    else if (isa<ConstantArrayType>(typePtr))
+    {
+        const ConstantArrayType *arrayType = cast<ConstantArrayType>(typePtr);
+        strstr << "A" << arrayType->getSize().getZExtValue() << "E" << getMangledNameForType(arrayType->getElementType());
+    }
+    else if (isa<RecordType>(typePtr))
+    {
+        const RecordDecl *recordDeclaration = cast<RecordType>(typePtr)->getDecl();
+
+        std::string name = getLengthPrefixedName(recordDeclaration->getNameAsString());
+
+        if (isa<ClassTemplateSpecializationDecl>(recordDeclaration))
         {
-            const ClassTemplateSpecializationDecl *classTemplateSpecialization = cast<ClassTemplateSpecializationDecl>(parent);
-            const TemplateArgumentList &templateArguments = classTemplateSpecialization->getTemplateArgs();
+            name += "I" + getMangledNameForTemplateArguments(cast<ClassTemplateSpecializationDecl>(recordDeclaration)->getTemplateArgs()) + "E";
+        }
 
-            for (int i = 0; i < templateArguments.size(); ++i)
+        strstr << getNestedName(recordDeclaration, name);
+    }
+    else if (isa<EnumType>(typePtr))
+    {
+        const EnumDecl *enumDeclaration = cast<EnumType>(typePtr)->getDecl();
+
+        strstr << getNestedName(enumDeclaration, getLengthPrefixedName(enumDeclaration->getNameAsString()));
+    }
+    else
+    {
+        strstr << getSanitizedName(canonicalType.getUnqualifiedType().getAsString());
+    }
+
+    return strstr.str();
+}
+
+std::string PatosNameMangling::getMangledNameForTemplateArgument(const TemplateArgument &argument)
+{
+    switch (argument.getKind())
+    {
+        case TemplateArgument::Type:
+            return getMangledNameForType(argument.getAsType());
+
+        case TemplateArgument::Integral:
+            return getMangledNameForIntegralValue(argument.getAsIntegral().toString(10));
+
+        case TemplateArgument::Pack:
+        {
+            std::stringstream strstr;
+            strstr << "J";
+            for (auto it = argument.pack_begin(); it != argument.pack_end(); ++it)
             {
-                strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << templateArguments.get(i).getAsType().getAsString();
+                if (it != argument.pack_begin())
+                {
+                    strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER;
+                }
+
+                strstr << getMangledNameForTemplateArgument(*it);
             }
+            strstr << "E";
+
+            return strstr.str();
+        }
+
+        default:
+            FAIL("unsupported kind of template argument (" << argument.getKind() << ")");
+    }
+}
+
+std::string PatosNameMangling::getMangledNameForFunction(const FunctionDecl *Declaration)
+{
+    std::stringstream strstr;
+
+    if (isa<CXXMethodDecl>(Declaration))
+    {
+        const CXXRecordDecl *parent = cast<CXXMethodDecl>(Declaration)->getParent();
+
+        if (isa<ClassTemplateSpecializationDecl>(parent))
+        {
+            strstr << getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(parent));
+        }
+        else
+        {
+            strstr << PatosNameMangling::MANGLED_NAME_RECORD_PREFIX << parent->getNameAsString();
         }
 
         strstr << PatosNameMangling::MANGLED_NAME_METHOD_RECORD_SEPARATOR;
@@ -64,8 +299,7 @@ std::string PatosNameMangling::getMangledNameForFunction(const FunctionDecl *Dec
 
         if (operatorKind < 0 || operatorKind >= OverloadedOperatorKind::NUM_OVERLOADED_OPERATORS)
         {
-            ERROR << "invalid operator kind (" << operatorKind << ")" << std::endl;
-            exit(EXIT_FAILURE);
+            FAIL("invalid operator kind (" << operatorKind << ")");
         }
 
         static const std::string operatorNames[OverloadedOperatorKind::NUM_OVERLOADED_OPERATORS] =
@@ -95,44 +329,398 @@ std::string PatosNameMangling::getMangledNameForFunction(const FunctionDecl *Dec
 
     // if method has template arguments, we have to add them to the mangled name
     const TemplateArgumentList *templateArguments = Declaration->getTemplateSpecializationArgs();
-    if (templateArguments != NULL)
+    if (templateArguments != NULL && templateArguments->size() > 0)
+    {
+        strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << getMangledNameForTemplateArguments(*templateArguments);
+    }
+
+    return strstr.str();
+}
+
+std::string PatosNameMangling::getMangledNameForRecord(const ClassTemplateSpecializationDecl *Declaration)
+{
+    std::stringstream strstr;
+
+    strstr << PatosNameMangling::MANGLED_NAME_RECORD_PREFIX << Declaration->getNameAsString();
+    strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << getMangledNameForTemplateArguments(Declaration->getTemplateArgs());
+
+    return strstr.str(); // strstrstrstrstrstr...
+}
+
+// ========== MANGLING OF TYPE SPELLINGS ==========
+//
+// template arguments given by the user (e.g. for explicit instantiations) are only available
+// as strings, so we parse their spelling to get the same encoding as for the canonical types
+// NOTE: typedef names cannot be resolved this way, i.e. the spelling has to be canonical
+
+class TypeSpellingParser
+{
+private:
+    std::vector<std::string> tokens;
+    unsigned position;
+
+    // set if the spelling could be tokenized, but not parsed (e.g. a literal out of range)
+    bool invalid;
+
+    bool isIdentifier(const std::string &token)
+    {
+        return !token.empty() && (std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_');
+    }
+
+    // OpenCL scalar types ('uint') and vector types ('float4') are encoded by their name
+    bool isOpenCLTypeName(const std::string &token)
+    {
+        static const char *scalarNames[] =
+            {
+                "char", "uchar", "short", "ushort", "int", "uint", "long", "ulong", "float", "double"
+            };
+
+        for (const char *scalarName : scalarNames)
+        {
+            std::string name(scalarName);
+
+            if (token.compare(0, name.size(), name) != 0)
+            {
+                continue;
+            }
+
+            std::string size = token.substr(name.size());
+            if ((size.empty() && name[0] == 'u') || size == "2" || size == "3" || size == "4" || size == "8" || size == "16")
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool isBuiltinWord(const std::string &token)
     {
-        for (int i = 0; i < templateArguments->size(); ++i)
+        static const char *builtinWords[] =
+            {
+                "void", "bool", "char", "short", "int", "long", "signed", "unsigned", "float", "double",
+                "half", "wchar_t", "char16_t", "char32_t", "__int128"
+            };
+
+        for (const char *word : builtinWords)
         {
-            strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER;
+            if (token == word)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const std::string &peek()
+    {
+        static const std::string end;
+        return (this->position < this->tokens.size()) ? this->tokens[this->position] : end;
+    }
+
+    // get the spelling clang uses for a combination of builtin type specifiers
+    std::string getBuiltinSpelling(const std::vector<std::string> &words)
+    {
+        unsigned numLong = 0;
+        bool isUnsigned = false, isSigned = false;
+        std::string base;
 
-            QualType templateQualType = templateArguments->get(i).getAsType();
-            const Type *templateType = templateQualType.getTypePtr();
+        for (auto it = words.begin(); it != words.end(); ++it)
+        {
+            if (*it == "long") ++numLong;
+            else if (*it == "unsigned") isUnsigned = true;
+            else if (*it == "signed") isSigned = true;
+            else if (*it != "int" || base.empty()) base = *it;
+        }
 
-            CXXRecordDecl *recordDeclaration = templateType->getAsCXXRecordDecl();
+        std::string prefix = isUnsigned ? "unsigned " : "";
 
-            if (recordDeclaration != NULL && isa<ClassTemplateSpecializationDecl>(recordDeclaration))
+        if (base == "char")
+        {
+            return isSigned ? "signed char" : prefix + "char";
+        }
+        if (base == "double")
+        {
+            return (numLong > 0) ? "long double" : "double";
+        }
+        if (base == "short")
+        {
+            return prefix + "short";
+        }
+        if (numLong > 0)
+        {
+            return prefix + ((numLong > 1) ? "long long" : "long");
+        }
+        if (base.empty() || base == "int")
+        {
+            return prefix + "int";
+        }
+
+        return prefix + base;
+    }
+
+    std::string parseArguments()
+    {
+        std::stringstream strstr;
+
+        bool first = true;
+        while (!this->peek().empty() && this->peek() != ">")
+        {
+            if (!first)
+            {
+                if (this->peek() != ",")
+                {
+                    break;
+                }
+
+                ++this->position;
+                strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER;
+            }
+
+            strstr << this->parseArgument();
+            first = false;
+        }
+
+        return strstr.str();
+    }
+
+public:
+    TypeSpellingParser(const std::string &spelling):
+        position(0), invalid(false)
+    {
+        // split spelling into identifiers, numbers and punctuation
+        for (unsigned idx = 0; idx < spelling.size(); )
+        {
+            char c = spelling[idx];
+
+            if (std::isspace(static_cast<unsigned char>(c)))
             {
-                strstr << PatosNameMangling::getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(recordDeclaration));
+                ++idx;
+            }
+            else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+            {
+                unsigned end = idx;
+                while (end < spelling.size() && (std::isalnum(static_cast<unsigned char>(spelling[end])) || spelling[end] == '_'))
+                {
+                    ++end;
+                }
+
+                this->tokens.push_back(spelling.substr(idx, end - idx));
+                idx = end;
+            }
+            else if (spelling.compare(idx, 2, "::") == 0 || spelling.compare(idx, 2, "&&") == 0)
+            {
+                this->tokens.push_back(spelling.substr(idx, 2));
+                idx += 2;
             }
             else
             {
-                strstr << templateQualType.getAsString();
+                this->tokens.push_back(std::string(1, c));
+                ++idx;
             }
         }
     }
 
-    return strstr.str();
-}
+    bool atEnd()
+    {
+        return this->position >= this->tokens.size();
+    }
 
-std::string PatosNameMangling::getMangledNameForRecord(const ClassTemplateSpecializationDecl *Declaration)
+    bool isInvalid()
+    {
+        return this->invalid;
+    }
+
+    std::string parseArgument()
+    {
+        // integral non-type arguments (suffixes and the base of the literal are dropped)
+        bool isNegative = false;
+        if (this->peek() == "-" && this->position + 1 < this->tokens.size() &&
+            std::isdigit(static_cast<unsigned char>(this->tokens[this->position + 1][0])))
+        {
+            isNegative = true;
+            ++this->position;
+        }
+
+        if (!this->peek().empty() && std::isdigit(static_cast<unsigned char>(this->peek()[0])))
+        {
+            const std::string &literal = this->tokens[this->position++];
+
+            std::string value;
+            try
+            {
+                value = std::to_string(std::stoull(literal, NULL, 0));
+            }
+            catch (std::logic_error const & ex)
+            {
+                ERROR << "unable to parse template argument: integer literal '" << literal << "' is out of range" << std::endl;
+
+                this->invalid = true;
+                return "";
+            }
+
+            return getMangledNameForIntegralValue((isNegative && value != "0") ? "-" + value : value);
+        }
+
+        if (this->peek() == "true" || this->peek() == "false")
+        {
+            return getMangledNameForIntegralValue(this->tokens[this->position++] == "true" ? "1" : "0");
+        }
+
+        return this->parseType();
+    }
+
+    std::string parseType()
+    {
+        bool isConst = false, isVolatile = false;
+        std::vector<std::string> builtinWords;
+        std::string base;
+
+        // specifiers
+        while (!this->atEnd())
+        {
+            const std::string &token = this->peek();
+
+            if (token == "const")
+            {
+                isConst = true;
+            }
+            else if (token == "volatile")
+            {
+                isVolatile = true;
+            }
+            else if (token == "struct" || token == "class" || token == "union" || token == "enum" || token == "typename")
+            {
+                // elaborated type specifiers do not change the type
+            }
+            else if (this->isBuiltinWord(token) && base.empty())
+            {
+                builtinWords.push_back(token);
+            }
+            else if (this->isOpenCLTypeName(token) && base.empty() && builtinWords.empty())
+            {
+                base = token;
+            }
+            else if ((this->isIdentifier(token) || token == "::") && base.empty() && builtinWords.empty())
+            {
+                // (possibly qualified) name, nested names as in getMangledNameForType()
+                // NOTE: the name has to be fully qualified, since scopes cannot be resolved here
+                if (token == "::")
+                {
+                    ++this->position;
+                }
+
+                std::vector<std::string> components;
+                while (this->isIdentifier(this->peek()))
+                {
+                    std::string component = getLengthPrefixedName(this->tokens[this->position++]);
+
+                    if (this->peek() == "<")
+                    {
+                        ++this->position;
+                        component += "I" + this->parseArguments() + "E";
+
+                        if (this->peek() == ">")
+                        {
+                            ++this->position;
+                        }
+                    }
+
+                    components.push_back(component);
+
+                    if (this->peek() != "::" || !this->isIdentifier(this->position + 1 < this->tokens.size() ? this->tokens[this->position + 1] : ""))
+                    {
+                        break;
+                    }
+
+                    ++this->position;
+                }
+
+                for (auto it = components.begin(); it != components.end(); ++it)
+                {
+                    base += *it;
+                }
+
+                if (components.size() > 1)
+                {
+                    base = "N" + base + "E";
+                }
+
+                continue;
+            }
+            else
+            {
+                break;
+            }
+
+            ++this->position;
+        }
+
+        if (!builtinWords.empty())
+        {
+            base = getCompactBuiltinName(this->getBuiltinSpelling(builtinWords));
+        }
+
+        std::string result = std::string(isConst ? "K" : "") + (isVolatile ? "V" : "") + base;
+
+        // declarators
+        while (!this->atEnd())
+        {
+            const std::string &token = this->peek();
+
+            if (token == "*")
+            {
+                ++this->position;
+
+                // qualifiers following the '*' belong to the pointer
+                bool isConstPointer = false, isVolatilePointer = false;
+                while (this->peek() == "const" || this->peek() == "volatile")
+                {
+                    (this->peek() == "const" ? isConstPointer : isVolatilePointer) = true;
+                    ++this->position;
+                }
+
+                result = std::string(isConstPointer ? "K" : "") + (isVolatilePointer ? "V" : "") + "P" + result;
+            }
+            else if (token == "&")
+            {
+                ++this->position;
+                result = "R" + result;
+            }
+            else if (token == "&&")
+            {
+                ++this->position;
+                result = "O" + result;
+            }
+            else if (token == "[" && this->position + 2 < this->tokens.size() && this->tokens[this->position + 2] == "]")
+            {
+                result = "A" + this->tokens[this->position + 1] + "E" + result;
+                this->position += 3;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        return result;
+    }
+};
+
+std::string PatosNameMangling::getMangledNameForTypeSpelling(const std::string &spelling)
 {
-    std::stringstream strstr;
+    TypeSpellingParser parser(spelling);
 
-    strstr << PatosNameMangling::MANGLED_NAME_RECORD_PREFIX << Declaration->getNameAsString();
+    std::string result = parser.parseArgument();
 
-    const TemplateArgumentList &templateArguments = Declaration->getTemplateArgs();
-    for (int i = 0; i < templateArguments.size(); ++i)
+    if (parser.isInvalid() || !parser.atEnd())
     {
-        strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << templateArguments.get(i).getAsType().getAsString();
+        // unknown syntax -> do not produce something that looks like a valid encoding
+        return getSanitizedName(spelling);
     }
 
-    return strstr.str(); // strstrstrstrstrstr...
+    return result;
 }
 
 std::string PatosNameMangling::getMangledNameForKernel(const std::string &kernelName, const std::vector<std::string> &templateArguments)
@@ -143,8 +731,7 @@ std::string PatosNameMangling::getMangledNameForKernel(const std::string &kernel
 
     for (auto it = templateArguments.begin(); it != templateArguments.end(); ++it)
     {
-        std::string templateArgument = *it;
-        strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << templateArgument;
+        strstr << PatosNameMangling::MANGLED_NAME_TYPE_DELIMITER << getMangledNameForTypeSpelling(*it);
     }
 
     return strstr.str();
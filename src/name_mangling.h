@@ -25,6 +25,7 @@
 #include <iterator>
 
 #include "clang/AST/Type.h"
+#include "clang/AST/TemplateBase.h"
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/Basic/OperatorKinds.h"
@@ -42,6 +43,13 @@ namespace PatosNameMangling
     extern const std::string MANGLED_NAME_METHOD_RECORD_SEPARATOR;
     extern const std::string MANGLED_NAME_OPERATOR;
 
+    // identifier-safe encoding of the canonical type (see name_mangling.cpp)
+    std::string getMangledNameForType(QualType type);
+    std::string getMangledNameForTemplateArgument(const TemplateArgument &argument);
+
+    // same encoding for a type given by its spelling (typedef names cannot be resolved)
+    std::string getMangledNameForTypeSpelling(const std::string &spelling);
+
     std::string getMangledNameForFunction(const FunctionDecl *Declaration);
     std::string getMangledNameForRecord(const ClassTemplateSpecializationDecl *Declaration);
 
@@ -16,6 +16,7 @@
 
 #include <string>
 #include <sstream>
+#include <utility>
 
 #include "parse.h"
 #include "common.h"
@@ -47,7 +48,53 @@ static const std::string OPENCL_KEYWORDS[NUM_OPENCL_KEYWORDS] =
                         "__kernel"
                     };
 
-void parseAndConsume(const std::string &fileName, PatosConsumer &consumer, std::vector<IncludePath> &includePaths, bool CPlusPlus, bool OpenCL)
+// OpenCL name and C++ type of the scalar types OpenCL provides vector types for
+#define NUM_OPENCL_SCALAR_TYPES 10
+static const std::pair<std::string, std::string> OPENCL_SCALAR_TYPES[NUM_OPENCL_SCALAR_TYPES] =
+                    {
+                        std::make_pair("char", "char"),
+                        std::make_pair("uchar", "unsigned char"),
+                        std::make_pair("short", "short"),
+                        std::make_pair("ushort", "unsigned short"),
+                        std::make_pair("int", "int"),
+                        std::make_pair("uint", "unsigned int"),
+                        std::make_pair("long", "long"),
+                        std::make_pair("ulong", "unsigned long"),
+                        std::make_pair("float", "float"),
+                        std::make_pair("double", "double")
+                    };
+
+#define NUM_OPENCL_VECTOR_SIZES 5
+static const unsigned OPENCL_VECTOR_SIZES[NUM_OPENCL_VECTOR_SIZES] = { 2, 3, 4, 8, 16 };
+
+std::string getMacroDirectives(const std::vector<MacroDefinition> &macros)
+{
+    std::stringstream directives;
+
+    for (auto it = macros.begin(); it != macros.end(); ++it)
+    {
+        if (it->second)
+        {
+            directives << "#undef " << it->first << std::endl;
+            continue;
+        }
+
+        std::string::size_type posEqual = it->first.find('=');
+        if (posEqual == std::string::npos)
+        {
+            directives << "#define " << it->first << " 1" << std::endl;
+        }
+        else
+        {
+            directives << "#define " << it->first.substr(0, posEqual) << " " << it->first.substr(posEqual + 1) << std::endl;
+        }
+    }
+
+    return directives.str();
+}
+
+void parseAndConsume(const std::string &fileName, PatosConsumer &consumer, std::vector<IncludePath> &includePaths, bool CPlusPlus, bool OpenCL,
+                     const std::vector<MacroDefinition> &macros)
 {
     // create a compiler instance that will hold the clang compiler
     // along with all the necessary data structures to run the compiler
@@ -120,8 +167,40 @@ void parseAndConsume(const std::string &fileName, PatosConsumer &consumer, std::
             {
                 predefines << "#define " << OPENCL_KEYWORDS[idx] << " __attribute__ ((annotate(\"__patos" << OPENCL_KEYWORDS[idx] << "\")))" << std::endl;
             }
+
+            // OpenCL scalar and vector types (vectors support swizzles like '.xy' or '.s01' in C++ as well)
+            for (unsigned idx = 0; idx < NUM_OPENCL_SCALAR_TYPES; ++idx)
+            {
+                const std::string &scalarName = OPENCL_SCALAR_TYPES[idx].first;
+
+                if (scalarName != OPENCL_SCALAR_TYPES[idx].second)
+                {
+                    predefines << "typedef " << OPENCL_SCALAR_TYPES[idx].second << " " << scalarName << ";" << std::endl;
+                }
+
+                for (unsigned sizeIdx = 0; sizeIdx < NUM_OPENCL_VECTOR_SIZES; ++sizeIdx)
+                {
+                    predefines << "typedef " << OPENCL_SCALAR_TYPES[idx].second << " " << scalarName << OPENCL_VECTOR_SIZES[sizeIdx]
+                               << " __attribute__ ((ext_vector_type(" << OPENCL_VECTOR_SIZES[sizeIdx] << ")));" << std::endl;
+                }
+            }
+
+            // marker for records whose arrays are passed to kernels as struct of arrays (see PassTransformation)
+            predefines << "#define __soa __attribute__ ((annotate(\"__patos__soa\")))" << std::endl;
+
+            // marker for records passed by value to their methods and operators (see PassTransformation)
+            predefines << "#define __value_type __attribute__ ((annotate(\"__patos__value_type\")))" << std::endl;
+
+            // marker for loops to unroll (N: unroll factor, 0: unroll completely; see PassTransformation)
+            predefines << "#define __unroll(N) if (0 && \"__patos__unroll\" && (N)) ; else" << std::endl;
+
+            // marker for typed launch wrappers in host sources (see PassScanLaunches)
+            predefines << "#define __launch(kernelFile, kernelName) __attribute__ ((annotate(\"__patos__launch:\" kernelFile \":\" kernelName)))" << std::endl;
         }
 
+        // define/undefine user-provided macros (in the order given)
+        predefines << getMacroDirectives(macros);
+
         // set predefines
         Preprocessor &preprocessor = compiler.getPreprocessor();
         preprocessor.setPredefines(predefines.str());
@@ -28,9 +28,19 @@
 
 typedef std::pair<std::string, clang::SrcMgr::CharacteristicKind> IncludePath;
 
+// macro definition as given to -D ("NAME" or "NAME=VALUE"),
+// second is true if the macro is undefined instead (-U)
+typedef std::pair<std::string, bool> MacroDefinition;
+
+/**
+ * Gets the preprocessor directives (#define/#undef) for the given macro definitions.
+ */
+std::string getMacroDirectives(const std::vector<MacroDefinition> &macros);
+
 /**
  * TODO comment
  */
-void parseAndConsume(const std::string &fileName, PatosConsumer &consumer, std::vector<IncludePath> &includePaths, bool CPlusPlus = true, bool OpenCL = false);
+void parseAndConsume(const std::string &fileName, PatosConsumer &consumer, std::vector<IncludePath> &includePaths, bool CPlusPlus = true, bool OpenCL = false,
+                     const std::vector<MacroDefinition> &macros = std::vector<MacroDefinition>());
 
 #endif
@@ -90,7 +90,7 @@ public:
         // intentionally left blank
     }
 
-    void HandleTranslationUnit(clang::ASTContext &context)
+    void processTranslationUnit(clang::ASTContext &context)
     {
         DBG << "Consume [REMOVE TEMPLATES]: " << this->FileName << std::endl;
 
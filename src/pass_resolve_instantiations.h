@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_PASS_RESOLVE_INSTANTIATIONS_H
+#define __INCLUDE_PASS_RESOLVE_INSTANTIATIONS_H
+
+#include <string>
+#include <stdlib.h>
+#include <map>
+
+#include "commandline.h"
+#include "common.h"
+#include "patos_consumer.h"
+#include "name_mangling.h"
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/SourceManager.h"
+
+using namespace clang;
+
+/**
+ * Pass for kernel files with appended explicit instantiations: gets the (type-mangled) names of
+ * the explicitly instantiated kernels without translating them. The names are derived from the
+ * canonical types, i.e. they are the same as the ones of the translation, whereas the spellings
+ * of the template arguments may use typedefs.
+ */
+class PassResolveInstantiations:
+    public PatosConsumer,
+    public RecursiveASTVisitor<PassResolveInstantiations>
+{
+private:
+    ASTContext *context;
+
+    // mangled names by the source line of the explicit instantiation
+    std::map<std::string, std::string> &mangledNames;
+
+    std::string getSourceLine(SourceLocation location)
+    {
+        SourceManager &sourceManager = this->context->getSourceManager();
+
+        std::pair<FileID, unsigned> decomposedLocation = sourceManager.getDecomposedLoc(sourceManager.getExpansionLoc(location));
+        std::string buffer = sourceManager.getBufferData(decomposedLocation.first).str();
+
+        std::string::size_type begin = buffer.rfind('\n', decomposedLocation.second);
+        begin = (begin == std::string::npos) ? 0 : begin + 1;
+
+        std::string::size_type end = buffer.find('\n', decomposedLocation.second);
+
+        return buffer.substr(begin, (end == std::string::npos) ? std::string::npos : end - begin);
+    }
+
+public:
+    PassResolveInstantiations(const std::string &FileName, struct Arguments &arguments, std::map<std::string, std::string> &mangledNames):
+        PatosConsumer(FileName, arguments),
+        mangledNames(mangledNames)
+    {
+        // intentionally left blank
+    }
+
+    void processTranslationUnit(clang::ASTContext &context)
+    {
+        DBG << "Consume [RESOLVE INSTANTIATIONS]: " << this->FileName << std::endl;
+
+        this->context = &context;
+        this->TraverseDecl(context.getTranslationUnitDecl());
+
+        // NOTE: kernel files are only read, not changed
+    }
+
+    bool VisitFunctionTemplateDecl(FunctionTemplateDecl *Declaration)
+    {
+        // explicit instantiations are not part of the declaration context, but specializations of the template
+        for (auto it = Declaration->spec_begin(); it != Declaration->spec_end(); ++it)
+        {
+            FunctionDecl *specialization = *it;
+
+            if (specialization->getTemplateSpecializationKind() != TSK_ExplicitInstantiationDefinition)
+            {
+                continue;
+            }
+
+            std::string mangledName = PatosNameMangling::getMangledNameForFunction(specialization);
+
+            DBG << "explicit instantiation of " << mangledName << " @" << specialization->getPointOfInstantiation().printToString(this->context->getSourceManager()) << std::endl;
+
+            this->mangledNames[this->getSourceLine(specialization->getPointOfInstantiation())] = mangledName;
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -48,7 +48,7 @@ public:
         // intentionally left blank
     }
 
-    void HandleTranslationUnit(clang::ASTContext &context)
+    void processTranslationUnit(clang::ASTContext &context)
     {
         DBG << "Consume [SANITIZE]: " << this->FileName << std::endl;
 
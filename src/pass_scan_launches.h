@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_PASS_SCAN_LAUNCHES_H
+#define __INCLUDE_PASS_SCAN_LAUNCHES_H
+
+#include <string>
+#include <stdlib.h>
+#include <vector>
+
+#include "commandline.h"
+#include "common.h"
+#include "patos_consumer.h"
+#include "instantiation_list.h"
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/Attr.h"
+#include "llvm/Support/raw_ostream.h"
+
+// prefix of the annotation created by the '__launch(kernelFile, kernelName)' macro
+#define PATOS_LAUNCH_ANNOTATION "__patos__launch:"
+
+using namespace clang;
+
+/**
+ * Pass for host sources: finds all references to specializations of typed launch wrappers,
+ * i.e. function templates declared with '__launch(kernelFile, kernelName)'. The template
+ * arguments and the parameter types of each referenced specialization give an instantiation
+ * of the kernel template (the wrapper's template and function parameters have to mirror
+ * the ones of the kernel).
+ */
+class PassScanLaunches:
+    public PatosConsumer,
+    public RecursiveASTVisitor<PassScanLaunches>
+{
+private:
+    ASTContext *context;
+
+    std::vector<KernelInstantiation> &instantiations;
+
+    bool getLaunchedKernel(FunctionDecl *Declaration, std::string &kernelFile, std::string &kernelName)
+    {
+        FunctionTemplateDecl *primaryTemplate = Declaration->getPrimaryTemplate();
+        if (primaryTemplate == NULL)
+        {
+            return false;
+        }
+
+        FunctionDecl *templatedDeclaration = primaryTemplate->getTemplatedDecl();
+        for (auto it = templatedDeclaration->attr_begin(); it != templatedDeclaration->attr_end(); ++it)
+        {
+            Attr *attribute = *it;
+
+            if (!isa<AnnotateAttr>(attribute))
+            {
+                continue;
+            }
+
+            std::string annotation = cast<AnnotateAttr>(attribute)->getAnnotation().str();
+            if (annotation.compare(0, std::string(PATOS_LAUNCH_ANNOTATION).size(), PATOS_LAUNCH_ANNOTATION) != 0)
+            {
+                continue;
+            }
+
+            // annotation is "<prefix><kernel file>:<kernel name>"
+            // NOTE: the kernel name cannot contain a ':', whereas the file name may
+            annotation = annotation.substr(std::string(PATOS_LAUNCH_ANNOTATION).size());
+            std::string::size_type posSeparator = annotation.rfind(':');
+            if (posSeparator == std::string::npos)
+            {
+                FAIL("invalid launch annotation of '" << templatedDeclaration->getNameAsString() << "'");
+            }
+
+            kernelFile = annotation.substr(0, posSeparator);
+            kernelName = annotation.substr(posSeparator + 1);
+            return true;
+        }
+
+        return false;
+    }
+
+    std::string printTemplateArgument(const TemplateArgument &argument)
+    {
+        if (argument.getKind() == TemplateArgument::Pack)
+        {
+            FAIL("template parameter packs are not supported for launch wrappers");
+        }
+
+        // print types canonically, so that the mangled names derived from the spellings
+        // match the ones of the translation (see PatosNameMangling::getMangledNameForTypeSpelling())
+        if (argument.getKind() == TemplateArgument::Type)
+        {
+            return argument.getAsType().getCanonicalType().getAsString(this->context->getPrintingPolicy());
+        }
+
+        std::string result;
+        llvm::raw_string_ostream stream(result);
+        argument.print(this->context->getPrintingPolicy(), stream);
+
+        return stream.str();
+    }
+
+public:
+    PassScanLaunches(const std::string &FileName, struct Arguments &arguments, std::vector<KernelInstantiation> &instantiations):
+        PatosConsumer(FileName, arguments),
+        instantiations(instantiations)
+    {
+        // intentionally left blank
+    }
+
+    void processTranslationUnit(clang::ASTContext &context)
+    {
+        DBG << "Consume [SCAN LAUNCHES]: " << this->FileName << std::endl;
+
+        this->context = &context;
+        this->TraverseDecl(context.getTranslationUnitDecl());
+
+        // NOTE: host sources are only read, not changed
+    }
+
+    bool TraverseDecl(Decl *Declaration)
+    {
+        // launches from system files are not of interest
+        if (!isInSystemFile(Declaration))
+        {
+            RecursiveASTVisitor::TraverseDecl(Declaration);
+        }
+
+        return true;
+    }
+
+    bool VisitDeclRefExpr(DeclRefExpr *Expression)
+    {
+        if (!isa<FunctionDecl>(Expression->getDecl()))
+        {
+            return true;
+        }
+
+        FunctionDecl *functionDeclaration = cast<FunctionDecl>(Expression->getDecl());
+
+        KernelInstantiation instantiation;
+        if (!this->getLaunchedKernel(functionDeclaration, instantiation.KernelFile, instantiation.KernelName))
+        {
+            return true;
+        }
+
+        const TemplateArgumentList *templateArguments = functionDeclaration->getTemplateSpecializationArgs();
+        for (unsigned idx = 0; idx < templateArguments->size(); ++idx)
+        {
+            instantiation.TemplateArguments.push_back(this->printTemplateArgument(templateArguments->get(idx)));
+        }
+
+        for (unsigned idx = 0; idx < functionDeclaration->getNumParams(); ++idx)
+        {
+            QualType parameterType = functionDeclaration->getParamDecl(idx)->getType().getCanonicalType();
+            instantiation.ArgumentTypes.push_back(parameterType.getAsString(this->context->getPrintingPolicy()));
+        }
+
+        instantiation.LaunchCount = 1;
+
+        DBG << "found launch of " << instantiation.KernelName << " (" << instantiation.KernelFile << ")"
+            << " @" << Expression->getLocStart().printToString(this->context->getSourceManager()) << std::endl;
+
+        addInstantiation(this->instantiations, instantiation);
+
+        return true;
+    }
+};
+
+#endif
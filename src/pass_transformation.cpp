@@ -17,11 +17,47 @@
 #include "pass_transformation.h"
 
 #define PATOS_KERNEL_ANNOTATION "__patos__kernel"
+#define PATOS_ANNOTATION_PREFIX "__patos"
+#define PATOS_PRIVATE_ADDRESS_SPACE "__private"
+#define PATOS_SOA_ANNOTATION "__patos__soa"
+#define PATOS_VALUE_TYPE_ANNOTATION "__patos__value_type"
+#define PATOS_UNROLL_ANNOTATION "__patos__unroll"
+
+#define SUFFIX_AMALGAMATION ".cl"
 
 // ================================================ //
 // ===== PASS_TRANSFORMATION: PRIVATE METHODS ===== //
 // ================================================ //
 
+// spelling of a (substituted) type in the generated code
+// (vectors by their OpenCL name, e.g. 'float4' instead of 'float __attribute__((ext_vector_type(4)))')
+PRIVATE std::string getOutputTypeSpelling(QualType type)
+{
+    QualType canonicalType = type.getCanonicalType();
+    const Type *typePtr = canonicalType.getTypePtr();
+
+    if (isa<PointerType>(typePtr))
+    {
+        return getOutputTypeSpelling(cast<PointerType>(typePtr)->getPointeeType()) + " *" +
+               (canonicalType.isConstQualified() ? " const" : "") + (canonicalType.isVolatileQualified() ? " volatile" : "");
+    }
+
+    std::string qualifiers = std::string(canonicalType.isConstQualified() ? "const " : "") + (canonicalType.isVolatileQualified() ? "volatile " : "");
+
+    if (isa<VectorType>(typePtr))
+    {
+        // the mangled names of vector types are their OpenCL names
+        return qualifiers + PatosNameMangling::getMangledNameForType(canonicalType.getUnqualifiedType());
+    }
+
+    if (isa<RecordType>(typePtr) && isa<ClassTemplateSpecializationDecl>(cast<RecordType>(typePtr)->getDecl()))
+    {
+        return qualifiers + PatosNameMangling::getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(cast<RecordType>(typePtr)->getDecl()));
+    }
+
+    return type.getAsString();
+}
+
 std::string PassTransformation::expressionToString(const Expr *Expression)
 {
     // try to get source from rewriter to capture any changes made to the expression
@@ -62,8 +98,7 @@ SourceLocation PassTransformation::getRealEndLocationForFunctionDeclaration(Func
         // assert valid source location
         if (locationEnd.isInvalid())
         {
-            ERROR << "invalid forward declaration of function '" << Declaration->getNameAsString() << "'" << std::endl;
-            exit(EXIT_FAILURE);
+            FAIL("invalid forward declaration of function '" << Declaration->getNameAsString() << "'");
         }
     }
 
@@ -120,6 +155,13 @@ std::string PassTransformation::createFlatVersionOfRecord(CXXRecordDecl *Declara
 
     strstr << structName << "\n{\n";
 
+    // types used by the members are referenced by the record
+    std::string oldOwner = this->currentOwner;
+    this->currentOwner = structName;
+
+    std::vector<FieldDecl *> fields;
+    std::vector<std::string> fieldSources;
+
     // iterate over all declarations to find the ones which have to be deleted
     // NOTE: first declaration in iterator is record declaration itself -> advance to first member
     for (auto declIt = ++Declaration->decls_begin(); declIt != Declaration->decls_end(); ++declIt)
@@ -135,18 +177,230 @@ std::string PassTransformation::createFlatVersionOfRecord(CXXRecordDecl *Declara
             std::string rewrittenText = this->currentRewriter->getRewrittenText(currentDeclaration->getSourceRange());
 
             // ...and add it to the list of members for the new record
-            strstr << "\t" << rewrittenText << ";\n";
+            fields.push_back(cast<FieldDecl>(currentDeclaration));
+            fieldSources.push_back(rewrittenText);
         }
     }
 
+    // members are emitted in declaration order, unless the layout is optimized
+    std::vector<unsigned> order;
+    for (unsigned idx = 0; idx < fields.size(); ++idx)
+    {
+        order.push_back(idx);
+    }
+
+    if (this->arguments.OptimizeLayout || this->arguments.WriteLayoutReport)
+    {
+        this->optimizeRecordLayout(Declaration, structName, fields, order);
+    }
+
+    for (auto it = order.begin(); it != order.end(); ++it)
+    {
+        strstr << "\t" << fieldSources[*it] << ";\n";
+    }
+
     strstr << "} " << structName << ";\n";
 
     // restore old state
     this->currentRewriter = oldRewriter;
+    this->currentOwner = oldOwner;
 
     return strstr.str();
 }
 
+class ASTVisitorFixedLayout: public RecursiveASTVisitor<ASTVisitorFixedLayout>
+{
+public:
+    std::vector<FunctionDecl *> functions;
+    std::vector<InitListExpr *> initializerLists;
+
+    bool shouldVisitTemplateInstantiations() const
+    {
+        return true;
+    }
+
+    bool VisitFunctionDecl(FunctionDecl *Declaration)
+    {
+        this->functions.push_back(Declaration);
+
+        return true;
+    }
+
+    bool VisitInitListExpr(InitListExpr *Expression)
+    {
+        this->initializerLists.push_back(Expression);
+
+        return true;
+    }
+};
+
+void PassTransformation::findRecordsWithFixedLayout(TranslationUnitDecl *TranslationUnit)
+{
+    ASTVisitorFixedLayout visitor;
+    visitor.TraverseDecl(TranslationUnit);
+
+    // records passed to kernels are shared with the host
+    for (auto it = visitor.functions.begin(); it != visitor.functions.end(); ++it)
+    {
+        FunctionDecl *function = *it;
+
+        if (!this->isKernelFunction(function))
+        {
+            continue;
+        }
+
+        for (unsigned idx = 0; idx < function->getNumParams(); ++idx)
+        {
+            this->markRecordsWithFixedLayout(function->getParamDecl(idx)->getType(), "kernel parameter");
+        }
+    }
+
+    // initializer lists depend on the order of the fields
+    for (auto it = visitor.initializerLists.begin(); it != visitor.initializerLists.end(); ++it)
+    {
+        this->markRecordsWithFixedLayout((*it)->getType(), "initializer list");
+    }
+}
+
+void PassTransformation::markRecordsWithFixedLayout(QualType type, const std::string &reason)
+{
+    // look through pointers and arrays
+    QualType currentType = type.getCanonicalType();
+    while (true)
+    {
+        if (currentType->isPointerType() || currentType->isReferenceType())
+        {
+            currentType = currentType->getPointeeType().getCanonicalType();
+        }
+        else if (currentType->isArrayType())
+        {
+            currentType = this->context->getAsArrayType(currentType)->getElementType().getCanonicalType();
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    CXXRecordDecl *record = currentType->getAsCXXRecordDecl();
+    if (record == NULL || this->fixedLayoutRecords.find(record->getCanonicalDecl()) != this->fixedLayoutRecords.end())
+    {
+        return;
+    }
+
+    this->fixedLayoutRecords[record->getCanonicalDecl()] = reason;
+
+    // the layout of nested records is shared, too
+    if (record->hasDefinition())
+    {
+        CXXRecordDecl *definition = record->getDefinition();
+        for (auto it = definition->field_begin(); it != definition->field_end(); ++it)
+        {
+            this->markRecordsWithFixedLayout(it->getType(), reason);
+        }
+    }
+}
+
+PRIVATE unsigned long alignOffset(unsigned long offset, unsigned long alignment)
+{
+    return (alignment == 0) ? offset : (offset + alignment - 1) / alignment * alignment;
+}
+
+// computes the layout of the flattened record and, if allowed, reorders the fields by decreasing
+// alignment (which minimizes the padding for power-of-two alignments)
+void PassTransformation::optimizeRecordLayout(CXXRecordDecl *Declaration, const std::string &recordName, const std::vector<FieldDecl *> &fields, std::vector<unsigned> &order)
+{
+    if (fields.empty() || Declaration->isDependentContext() || Declaration->isInvalidDecl() || !Declaration->isCompleteDefinition())
+    {
+        return;
+    }
+
+    const ASTRecordLayout &recordLayout = this->context->getASTRecordLayout(Declaration);
+
+    RecordLayoutInfo layout;
+    layout.RecordName = recordName;
+    layout.Size = recordLayout.getSize().getQuantity();
+    layout.Alignment = recordLayout.getAlignment().getQuantity();
+    layout.Reordered = false;
+
+    unsigned long fieldBytes = 0;
+    for (auto it = fields.begin(); it != fields.end(); ++it)
+    {
+        FieldDecl *field = *it;
+
+        std::pair<CharUnits, CharUnits> typeInfo = this->context->getTypeInfoInChars(field->getType());
+
+        FieldLayoutInfo fieldLayout;
+        fieldLayout.Name = field->getNameAsString();
+        fieldLayout.Type = field->getType().getAsString();
+        fieldLayout.Size = typeInfo.first.getQuantity();
+        fieldLayout.Alignment = typeInfo.second.getQuantity();
+        fieldLayout.Offset = this->context->toCharUnitsFromBits(recordLayout.getFieldOffset(field->getFieldIndex())).getQuantity();
+        fieldLayout.OptimizedOffset = fieldLayout.Offset;
+
+        if (field->isBitField())
+        {
+            layout.FixedLayoutReason = "bit-fields";
+        }
+
+        fieldBytes += fieldLayout.Size;
+        layout.Fields.push_back(fieldLayout);
+    }
+
+    layout.WastedBytes = (layout.Size > fieldBytes) ? layout.Size - fieldBytes : 0;
+
+    // fields with the same alignment keep their relative order
+    std::vector<unsigned> optimizedOrder(order);
+    std::stable_sort(optimizedOrder.begin(), optimizedOrder.end(), [&layout](unsigned a, unsigned b)
+    {
+        return layout.Fields[a].Alignment > layout.Fields[b].Alignment;
+    });
+
+    unsigned long offset = 0;
+    for (auto it = optimizedOrder.begin(); it != optimizedOrder.end(); ++it)
+    {
+        FieldLayoutInfo &fieldLayout = layout.Fields[*it];
+
+        offset = alignOffset(offset, fieldLayout.Alignment);
+        fieldLayout.OptimizedOffset = offset;
+        offset += fieldLayout.Size;
+    }
+
+    layout.OptimizedSize = alignOffset(offset, layout.Alignment);
+    layout.OptimizedWastedBytes = (layout.OptimizedSize > fieldBytes) ? layout.OptimizedSize - fieldBytes : 0;
+
+    if (layout.FixedLayoutReason.empty() && Declaration->getNumBases() > 0)
+    {
+        layout.FixedLayoutReason = "base classes";
+    }
+
+    // records are flattened into the header declaring them, which is shared with other files
+    // (whose kernels may get the record from the host)
+    if (layout.FixedLayoutReason.empty() && !this->context->getSourceManager().isInMainFile(Declaration->getLocation()))
+    {
+        layout.FixedLayoutReason = "declared in a header";
+    }
+
+    if (layout.FixedLayoutReason.empty())
+    {
+        auto itFixed = this->fixedLayoutRecords.find(Declaration->getCanonicalDecl());
+        if (itFixed != this->fixedLayoutRecords.end())
+        {
+            layout.FixedLayoutReason = itFixed->second;
+        }
+    }
+
+    if (this->arguments.OptimizeLayout && layout.FixedLayoutReason.empty() && layout.OptimizedSize < layout.Size)
+    {
+        DBG << "reordered fields of " << recordName << " (" << layout.Size << " -> " << layout.OptimizedSize << " bytes)" << std::endl;
+
+        order = optimizedOrder;
+        layout.Reordered = true;
+    }
+
+    this->results.addRecordLayout(layout);
+}
+
 void PassTransformation::removeDeclarationOrRememberToRemoveInTheFuture(Decl *Declaration)
 {
     SourceLocation locationDeclaration = Declaration->getLocStart();
@@ -225,225 +479,2460 @@ bool PassTransformation::isKernelFunction(FunctionDecl *Declaration)
     return false;
 }
 
-void PassTransformation::transformFunction(FunctionDecl *Declaration, const SourceLocation &insertLocation, bool addDefinitionToMainFile)
+PRIVATE bool hasAnnotation(const Decl *Declaration, const std::string &annotation)
 {
-    // traverse specialization to perform type substitution, name mangling, call replacement, etc.
-    if (isa<CXXMethodDecl>(Declaration))
+    for (auto it = Declaration->attr_begin(); it != Declaration->attr_end(); ++it)
     {
-        TraverseCXXMethodDecl(cast<CXXMethodDecl>(Declaration));
+        if (isa<AnnotateAttr>(*it) && cast<AnnotateAttr>(*it)->getAnnotation().str() == annotation)
+        {
+            return true;
+        }
     }
-    else
+
+    return false;
+}
+
+// records annotated with '__value_type' (or specializations of annotated class templates)
+PRIVATE bool isValueTypeRecord(const CXXRecordDecl *Declaration)
+{
+    if (hasAnnotation(Declaration, PATOS_VALUE_TYPE_ANNOTATION))
     {
-        TraverseFunctionDecl(Declaration);
+        return true;
     }
 
-    // add transformed version to rewriter
+    if (isa<ClassTemplateSpecializationDecl>(Declaration))
     {
-        // unfortunately, the function signature's locations point to the declaration,
-        // whereas the locations for the function's body point to the definition
-        // -> gather rewritten code of signature and body from different locations
+        ClassTemplateDecl *classTemplate = cast<ClassTemplateSpecializationDecl>(Declaration)->getSpecializedTemplate();
 
-        std::stringstream strRewrittenText;
-        strRewrittenText << "\n";
+        return hasAnnotation(classTemplate->getTemplatedDecl(), PATOS_VALUE_TYPE_ANNOTATION);
+    }
 
-        // if function is a kernel function, we have to add a '__kernel' before it
-        if (isKernelFunction(Declaration))
-        {
-            strRewrittenText << "__kernel ";
-        }
+    return false;
+}
 
-        // if function is a constructor, we have to add the return type before it
-        if (isa<CXXConstructorDecl>(Declaration))
-        {
-            CXXConstructorDecl *constructorDeclaration = cast<CXXConstructorDecl>(Declaration);
-            CXXRecordDecl *parent = constructorDeclaration->getParent();
+// records without any data (e.g. functors), whose methods do not need an instance
+PRIVATE bool isEmptyRecord(const CXXRecordDecl *Declaration)
+{
+    if (Declaration == NULL || !Declaration->hasDefinition())
+    {
+        return false;
+    }
 
-            // get name of parent
-            std::string parentName;
-            if (isa<ClassTemplateSpecializationDecl>(parent))
-            {
-                // parent is a class template specialization
-                // -> get mangled name
-                parentName = PatosNameMangling::getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(parent));
-            }
-            else
-            {
-                // parent is a 'normal' record
-                parentName = parent->getNameAsString();
-            }
+    const CXXRecordDecl *definition = Declaration->getDefinition();
 
-            // add return type
-            strRewrittenText << "struct " << parentName << " ";
-        }
+    return definition->field_empty() && definition->getNumBases() == 0;
+}
 
-        // rewritten code of signature
-        strRewrittenText << this->currentRewriter->getRewrittenText(getSignatureSourceRange(Declaration));
+// small records are passed by value to their const methods, so that the caller's object
+// does not have to be addressable (and may stay in registers)
+// NOTE: value types are passed by value regardless of their size
+bool PassTransformation::passesInstanceByValue(CXXMethodDecl *Declaration)
+{
+    bool isValueType = isValueTypeRecord(Declaration->getParent());
 
-        // add declaration to source
-        std::string declarationSource = strRewrittenText.str() + ";\n";
-        this->rewriter->InsertTextAfter(insertLocation, declarationSource);
+    if (this->arguments.ByValueMaxSize == 0 && !isValueType)
+    {
+        return false;
+    }
 
-        // rewritten code of body (if any)
-        if (addDefinitionToMainFile && Declaration->hasBody())
-        {
-            strRewrittenText << "\n" << this->currentRewriter->getRewrittenText(Declaration->getBody()->getSourceRange()) << "\n";
+    if (isa<CXXConstructorDecl>(Declaration) || isa<CXXDestructorDecl>(Declaration) || Declaration->isStatic() || !Declaration->isConst())
+    {
+        return false;
+    }
 
-            // this is a definition
-            // definitions have to be added to the _module_, i.e. we have to insert it in the main file
-            SourceLocation locationModule = this->context->getSourceManager().getLocForEndOfFile(this->context->getSourceManager().getMainFileID());
-            this->rewriter->InsertTextAfter(locationModule, strRewrittenText.str());
-        }
+    // the result might point into the (copied) instance
+    QualType returnType = Declaration->getReturnType();
+    if (returnType->isPointerType() || returnType->isReferenceType())
+    {
+        return false;
     }
-}
 
-bool PassTransformation::hasAlreadyADeclaration(const std::string &declarationName)
-{
-    // iterate over all declarations in the AST
-    TranslationUnitDecl *translationUnit = this->context->getTranslationUnitDecl();
-    for (auto it = translationUnit->decls_begin(); it != translationUnit->decls_end(); ++it)
+    CXXRecordDecl *parent = Declaration->getParent();
+    if (parent->isDependentContext() || !parent->isCompleteDefinition())
     {
-        Decl *otherDeclaration = *it;
+        return false;
+    }
 
-        if (isa<NamedDecl>(otherDeclaration))
+    // const methods may still modify mutable members
+    for (auto it = parent->field_begin(); it != parent->field_end(); ++it)
+    {
+        if (it->isMutable())
         {
-            if (cast<NamedDecl>(otherDeclaration)->getNameAsString() == declarationName)
-            {
-                return true;
-            }
+            return false;
         }
     }
 
-    return false;
+    if (isValueType)
+    {
+        return true;
+    }
+
+    CharUnits size = this->context->getTypeSizeInChars(this->context->getRecordType(parent));
+
+    return static_cast<unsigned long>(size.getQuantity()) <= this->arguments.ByValueMaxSize;
 }
 
-// NOTE: this method returns a source range *including* the opening parenthesis of the call expression
-// (possibly followed by some whitespace)
-SourceRange PassTransformation::getRealCalleeSourceRange(const CallExpr *Expression)
+// methods of empty records neither get nor need an instance
+bool PassTransformation::needsInstance(CXXMethodDecl *Declaration)
 {
-    // get source range for callee
-    // unfortunately, clang provides the wrong range for our purpose if explicit template arguments are specified:
-    //    foo<bar>()
-    //    ^~^ clang only provides this source range
-
-    SourceLocation locationBegin = Expression->getCallee()->getLocStart();
+    return isa<CXXConstructorDecl>(Declaration) || !isEmptyRecord(Declaration->getParent());
+}
 
-    SourceLocation locationEnd;
-    
-    if (Expression->getNumArgs() > 0)
+// large records are initialized in place by their constructors instead of copying the constructed record
+bool PassTransformation::constructsInPlace(CXXConstructorDecl *Declaration)
+{
+    // value types are meant to stay in registers
+    if (this->arguments.InPlaceMinSize == 0 || Declaration->isImplicit() || isInSystemFile(Declaration) ||
+        isValueTypeRecord(Declaration->getParent()))
     {
-        locationEnd = Expression->getArg(0)->getLocStart().getLocWithOffset(-1);
+        return false;
     }
-    else
+
+    CXXRecordDecl *parent = Declaration->getParent();
+    if (parent->isDependentContext() || !parent->isCompleteDefinition())
     {
-        locationEnd = Expression->getRParenLoc().getLocWithOffset(-1);
+        return false;
     }
 
-    return SourceRange(locationBegin, locationEnd);
+    CharUnits size = this->context->getTypeSizeInChars(this->context->getRecordType(parent));
+
+    return static_cast<unsigned long>(size.getQuantity()) >= this->arguments.InPlaceMinSize;
 }
 
-SourceRange PassTransformation::getDeclaratorSourceRange(FunctionDecl *Declaration)
+class ASTVisitorLoopCalls: public RecursiveASTVisitor<ASTVisitorLoopCalls>
 {
-    if (isa<CXXMethodDecl>(Declaration))
-    {
-        CXXMethodDecl *MethodDeclaration = cast<CXXMethodDecl>(Declaration);
+private:
+    unsigned loopDepth;
 
-        if (MethodDeclaration->getParent() != MethodDeclaration->getLexicalParent())
-        {
-            // compute source range of 'qualified' declarator
-            //
-            // void FOO::bar()
-            //      ^------^ this is what we want
-            //           ^-^ this is what clang gives us...
-            //
-            // (did not find a better way...)
+public:
+    std::set<const FunctionDecl *> callees;
 
-            const SourceManager &sourceManager = this->context->getSourceManager();
-            const LangOptions &languageOptions = this->context->getLangOpts();
+    ASTVisitorLoopCalls():
+        loopDepth(0)
+    {
+        // intentionally left blank
+    }
+
+    bool shouldVisitTemplateInstantiations() const
+    {
+        return true;
+    }
+
+    bool TraverseForStmt(ForStmt *Statement)
+    {
+        ++this->loopDepth;
+        RecursiveASTVisitor::TraverseForStmt(Statement);
+        --this->loopDepth;
+
+        return true;
+    }
+
+    bool TraverseWhileStmt(WhileStmt *Statement)
+    {
+        ++this->loopDepth;
+        RecursiveASTVisitor::TraverseWhileStmt(Statement);
+        --this->loopDepth;
+
+        return true;
+    }
+
+    bool TraverseDoStmt(DoStmt *Statement)
+    {
+        ++this->loopDepth;
+        RecursiveASTVisitor::TraverseDoStmt(Statement);
+        --this->loopDepth;
+
+        return true;
+    }
+
+    bool VisitCallExpr(CallExpr *Expression)
+    {
+        const FunctionDecl *callee = Expression->getDirectCallee();
+
+        if (this->loopDepth > 0 && callee != NULL)
+        {
+            this->callees.insert(callee->getCanonicalDecl());
+        }
+
+        return true;
+    }
+
+    bool VisitCXXConstructExpr(CXXConstructExpr *Expression)
+    {
+        if (this->loopDepth > 0 && Expression->getConstructor() != NULL)
+        {
+            this->callees.insert(Expression->getConstructor()->getCanonicalDecl());
+        }
+
+        return true;
+    }
+};
+
+class ASTVisitorStatementCounter: public RecursiveASTVisitor<ASTVisitorStatementCounter>
+{
+public:
+    unsigned long statements;
+
+    ASTVisitorStatementCounter():
+        statements(0)
+    {
+        // intentionally left blank
+    }
+
+    bool VisitStmt(Stmt *Statement)
+    {
+        // expressions are part of statements and blocks only group them
+        if (!isa<Expr>(Statement) && !isa<CompoundStmt>(Statement))
+        {
+            ++this->statements;
+        }
+
+        return true;
+    }
+};
+
+void PassTransformation::findFunctionsCalledInsideLoops(TranslationUnitDecl *TranslationUnit)
+{
+    ASTVisitorLoopCalls visitor;
+    visitor.TraverseDecl(TranslationUnit);
+
+    this->calledInsideLoops = visitor.callees;
+}
+
+// small functions and functions called inside loops are always inlined
+bool PassTransformation::isAlwaysInlined(FunctionDecl *Declaration)
+{
+    if (this->arguments.InlineThreshold == 0 || this->isKernelFunction(Declaration) || !Declaration->hasBody())
+    {
+        return false;
+    }
+
+    if (this->calledInsideLoops.find(Declaration->getCanonicalDecl()) != this->calledInsideLoops.end())
+    {
+        return true;
+    }
+
+    ASTVisitorStatementCounter counter;
+    counter.TraverseStmt(Declaration->getBody());
+
+    return counter.statements < this->arguments.InlineThreshold;
+}
+
+class ASTVisitorRecursiveCalls: public RecursiveASTVisitor<ASTVisitorRecursiveCalls>
+{
+private:
+    const FunctionDecl *function;
+
+public:
+    std::vector<CallExpr *> calls;
+    std::vector<ReturnStmt *> returns;
+
+    ASTVisitorRecursiveCalls(const FunctionDecl *function):
+        function(function)
+    {
+        // intentionally left blank
+    }
+
+    bool VisitCallExpr(CallExpr *Expression)
+    {
+        const FunctionDecl *callee = Expression->getDirectCallee();
+        if (callee != NULL && callee->getCanonicalDecl() == this->function->getCanonicalDecl())
+        {
+            this->calls.push_back(Expression);
+        }
+
+        return true;
+    }
+
+    bool VisitReturnStmt(ReturnStmt *Statement)
+    {
+        this->returns.push_back(Statement);
+
+        return true;
+    }
+};
+
+// expression whose value does not change during the execution of other calls, i.e. it has no side effects and
+// does not read from memory (e.g. 'count-i-2' or '&items[i+2]', but not 'items[i]' or '&local')
+PRIVATE bool isStableExpression(const Expr *Expression, bool addressOnly = false)
+{
+    Expression = Expression->IgnoreParenImpCasts();
+
+    if (isa<IntegerLiteral>(Expression) || isa<FloatingLiteral>(Expression) || isa<CharacterLiteral>(Expression) ||
+        isa<CXXBoolLiteralExpr>(Expression) || isa<UnaryExprOrTypeTraitExpr>(Expression))
+    {
+        return !addressOnly;
+    }
+
+    if (isa<DeclRefExpr>(Expression))
+    {
+        // NOTE: the address of a local variable refers to the frame of the current call
+        const ValueDecl *declaration = cast<DeclRefExpr>(Expression)->getDecl();
+
+        if (isa<EnumConstantDecl>(declaration))
+        {
+            return !addressOnly;
+        }
+
+        return !addressOnly && isa<VarDecl>(declaration) && cast<VarDecl>(declaration)->hasLocalStorage() &&
+               !declaration->getType()->isReferenceType() && !declaration->getType()->isArrayType();
+    }
+
+    if (isa<ArraySubscriptExpr>(Expression))
+    {
+        const ArraySubscriptExpr *subscript = cast<ArraySubscriptExpr>(Expression);
+
+        return addressOnly && subscript->getBase()->IgnoreParenImpCasts()->getType()->isPointerType() &&
+               isStableExpression(subscript->getBase()) && isStableExpression(subscript->getIdx());
+    }
+
+    if (isa<MemberExpr>(Expression))
+    {
+        const MemberExpr *member = cast<MemberExpr>(Expression);
+
+        if (member->isArrow())
+        {
+            return addressOnly && isStableExpression(member->getBase());
+        }
+
+        return isStableExpression(member->getBase(), addressOnly);
+    }
+
+    if (isa<UnaryOperator>(Expression))
+    {
+        const UnaryOperator *unary = cast<UnaryOperator>(Expression);
+
+        switch (unary->getOpcode())
+        {
+            case UO_AddrOf:
+                return !addressOnly && isStableExpression(unary->getSubExpr(), true);
+            case UO_Deref:
+                return addressOnly && isStableExpression(unary->getSubExpr());
+            case UO_Plus:
+            case UO_Minus:
+            case UO_Not:
+            case UO_LNot:
+                return !addressOnly && isStableExpression(unary->getSubExpr());
+            default:
+                return false;
+        }
+    }
+
+    if (isa<BinaryOperator>(Expression))
+    {
+        const BinaryOperator *binary = cast<BinaryOperator>(Expression);
+
+        return !addressOnly && !binary->isAssignmentOp() && binary->getOpcode() != BO_Comma &&
+               isStableExpression(binary->getLHS()) && isStableExpression(binary->getRHS());
+    }
+
+    if (isa<ConditionalOperator>(Expression))
+    {
+        const ConditionalOperator *conditional = cast<ConditionalOperator>(Expression);
+
+        return !addressOnly && isStableExpression(conditional->getCond()) &&
+               isStableExpression(conditional->getTrueExpr()) && isStableExpression(conditional->getFalseExpr());
+    }
+
+    if (isa<ExplicitCastExpr>(Expression))
+    {
+        return !addressOnly && isStableExpression(cast<ExplicitCastExpr>(Expression)->getSubExpr());
+    }
+
+    return false;
+}
+
+// OpenCL C does not support recursion
+// -> self-recursive functions whose recursive calls are the last statements of their body (e.g. quicksort)
+//    are turned into a loop over an explicit stack of frames (holding the parameters) in private memory
+// NOTE: the stack never overflows, its depth is inferred from the recursive calls (otherwise the translation fails)
+// NOTE: the body must already be transformed, the loop is built around the rewritten code
+void PassTransformation::eliminateRecursion(FunctionDecl *Declaration)
+{
+    if (!Declaration->hasBody() || !isa<CompoundStmt>(Declaration->getBody()))
+    {
+        return;
+    }
+
+    CompoundStmt *body = cast<CompoundStmt>(Declaration->getBody());
+
+    ASTVisitorRecursiveCalls visitor(Declaration);
+    visitor.TraverseStmt(body);
+
+    if (visitor.calls.empty())
+    {
+        return;
+    }
+
+    std::string functionName = this->getEmittedName(Declaration);
+
+    DBG << "eliminate recursion of " << functionName << std::endl;
+
+    if (isa<CXXMethodDecl>(Declaration) || !Declaration->getReturnType()->isVoidType())
+    {
+        FAIL("recursive function '" << functionName << "' cannot be made iterative (only functions returning void are supported)");
+    }
+
+    // the recursive calls have to be the trailing statements of the body
+    // (nothing but other recursive calls is executed after the first one returns)
+    std::set<const CallExpr *> trailingCalls;
+    for (auto it = body->body_rbegin(); it != body->body_rend(); ++it)
+    {
+        if (!isa<Expr>(*it) || !isa<CallExpr>(cast<Expr>(*it)->IgnoreImplicit()))
+        {
+            break;
+        }
+
+        const CallExpr *call = cast<CallExpr>(cast<Expr>(*it)->IgnoreImplicit());
+        if (std::find(visitor.calls.begin(), visitor.calls.end(), call) == visitor.calls.end())
+        {
+            break;
+        }
+
+        trailingCalls.insert(call);
+    }
+
+    if (trailingCalls.size() != visitor.calls.size())
+    {
+        FAIL("recursive function '" << functionName << "' cannot be made iterative (the recursive calls have to be the last statements of its body)");
+    }
+
+    // all arguments are evaluated before the first call is executed
+    for (auto it = visitor.calls.begin(); it != visitor.calls.end(); ++it)
+    {
+        for (unsigned argIdx = 0; argIdx < (*it)->getNumArgs(); ++argIdx)
+        {
+            if (!isStableExpression((*it)->getArg(argIdx)))
+            {
+                FAIL("recursive function '" << functionName << "' cannot be made iterative (argument '" << this->expressionToString((*it)->getArg(argIdx))
+                     << "' of a recursive call might be changed by a preceding call, e.g. because it reads from memory)");
+            }
+        }
+    }
+
+    // the last integral parameter is taken as the size of a call (e.g. 'count')
+    int sizeIdx = -1;
+    for (unsigned paramIdx = 0; paramIdx < Declaration->getNumParams(); ++paramIdx)
+    {
+        if (Declaration->getParamDecl(paramIdx)->getType()->isIntegerType())
+        {
+            sizeIdx = paramIdx;
+        }
+    }
+
+    // infer the number of frames
+    // - a single call replaces the frame of the current call (i.e. a loop)
+    // - if the smaller of two calls is executed first, its size is at most half of the current one, so
+    //   every frame on the stack (except for the top one) at most halves the size: one frame per bit of the size
+    // NOTE: in any other case, the number of frames depends on the input
+    bool reorderCalls = false;
+    unsigned long frames = 0;
+
+    if (visitor.calls.size() == 1)
+    {
+        frames = 1;
+    }
+    else if (visitor.calls.size() == 2 && this->arguments.RecursionReorderCalls)
+    {
+        if (sizeIdx < 0)
+        {
+            FAIL("recursive function '" << functionName << "' cannot be made iterative (the calls can only be reordered by an integral parameter)");
+        }
+
+        reorderCalls = true;
+        frames = this->context->getTypeSize(Declaration->getParamDecl(sizeIdx)->getType()) + 1;
+    }
+    else
+    {
+        FAIL("recursive function '" << functionName << "' cannot be made iterative (the depth of its stack cannot be bounded"
+             << (visitor.calls.size() == 2 ? ", see --recursion-reorder-calls)" : ")"));
+    }
+
+    if (this->arguments.RecursionStackDepth > 0 && frames > this->arguments.RecursionStackDepth)
+    {
+        FAIL("recursive function '" << functionName << "' cannot be made iterative (it needs " << frames << " frames, but --recursion-stack-depth is "
+             << this->arguments.RecursionStackDepth << ")");
+    }
+
+    DBG << "explicit stack of " << functionName << ": " << frames << " frames" << std::endl;
+
+    const std::string depth = std::to_string(frames);
+
+    // stack of frames, holding the parameters of each pending call
+    std::stringstream prologue;
+    std::stringstream restoreParameters;
+    {
+        std::stringstream fields;
+        std::stringstream pushParameters;
+
+        for (unsigned paramIdx = 0; paramIdx < Declaration->getNumParams(); ++paramIdx)
+        {
+            ParmVarDecl *parameter = Declaration->getParamDecl(paramIdx);
+            std::string parameterName = parameter->getNameAsString();
+
+            if (parameterName.empty() || parameter->getType().isConstQualified())
+            {
+                FAIL("recursive function '" << functionName << "' cannot be made iterative (all parameters have to be named and non-const)");
+            }
+
+            fields << this->currentRewriter->getRewrittenText(parameter->getSourceRange()) << "; ";
+            pushParameters << "__patos_frames[0]." << parameterName << " = " << parameterName << ";\n\t";
+            restoreParameters << parameterName << " = __patos_frames[__patos_top]." << parameterName << ";\n\t";
+        }
+
+        prologue << "\n\t/* BEGIN RECURSION ELIMINATION */\n\t"
+                 << "struct { " << fields.str() << "} __patos_frames[" << depth << "];\n\t"
+                 << "int __patos_top = 1;\n\t"
+                 << pushParameters.str()
+                 << "while (__patos_top > 0)\n\t{\n\t"
+                 << "--__patos_top;\n\t"
+                 << restoreParameters.str();
+    }
+
+    // returning from a call continues with the next frame
+    for (auto it = visitor.returns.begin(); it != visitor.returns.end(); ++it)
+    {
+        this->currentRewriter->ReplaceText((*it)->getSourceRange(), "goto __patos_return");
+    }
+
+    // calls push a frame
+    std::vector<std::string> pushes;
+    for (auto it = visitor.calls.begin(); it != visitor.calls.end(); ++it)
+    {
+        std::stringstream push;
+        push << "{ ";
+        for (unsigned argIdx = 0; argIdx < (*it)->getNumArgs(); ++argIdx)
+        {
+            push << "__patos_frames[__patos_top]." << Declaration->getParamDecl(argIdx)->getNameAsString()
+                 << " = " << this->expressionToString((*it)->getArg(argIdx)) << "; ";
+        }
+        push << "++__patos_top; }";
+
+        pushes.push_back(push.str());
+    }
+
+    // NOTE: the arguments are rendered before any call is replaced
+    if (reorderCalls)
+    {
+        // the larger call is pushed first, so the smaller one is executed next
+        // (like in quicksort, this bounds the number of frames by the logarithm of the size)
+        std::string size0 = this->expressionToString(visitor.calls[0]->getArg(sizeIdx));
+        std::string size1 = this->expressionToString(visitor.calls[1]->getArg(sizeIdx));
+
+        this->currentRewriter->ReplaceText(visitor.calls[0]->getSourceRange(),
+                                           "if ((" + size0 + ") >= (" + size1 + ")) { " + pushes[0] + " " + pushes[1] + " } " +
+                                           "else { " + pushes[1] + " " + pushes[0] + " }");
+        this->currentRewriter->ReplaceText(visitor.calls[1]->getSourceRange(), "");
+    }
+    else
+    {
+        // a single call (the frame is pushed after the current one has been popped)
+        this->currentRewriter->ReplaceText(visitor.calls[0]->getSourceRange(), pushes[0]);
+    }
+
+    this->currentRewriter->InsertTextAfterToken(body->getLBracLoc(), prologue.str());
+    this->currentRewriter->InsertTextBefore(body->getRBracLoc(), "__patos_return: ;\n\t}\n\t/* END RECURSION ELIMINATION */\n");
+}
+
+void PassTransformation::transformFunction(FunctionDecl *Declaration, const SourceLocation &insertLocation, bool addDefinitionToMainFile)
+{
+    // traverse specialization to perform type substitution, name mangling, call replacement, etc.
+    if (isa<CXXMethodDecl>(Declaration))
+    {
+        TraverseCXXMethodDecl(cast<CXXMethodDecl>(Declaration));
+    }
+    else
+    {
+        TraverseFunctionDecl(Declaration);
+    }
+
+    // add transformed version to rewriter
+    {
+        // unfortunately, the function signature's locations point to the declaration,
+        // whereas the locations for the function's body point to the definition
+        // -> gather rewritten code of signature and body from different locations
+
+        std::stringstream strRewrittenText;
+        strRewrittenText << "\n";
+
+        // if function is a kernel function, we have to add a '__kernel' before it
+        if (isKernelFunction(Declaration))
+        {
+            strRewrittenText << "__kernel ";
+        }
+        else
+        {
+            SourceManager &sourceManager = this->context->getSourceManager();
+
+            // kernels are the only entry points of the program
+            // NOTE: inline functions are always static, since a C99 inline definition does not provide
+            // an external definition (which is missing if the compiler does not inline a call)
+            // NOTE: prototypes inserted into headers are shared with other files, which do not get a definition
+            // (it is only emitted into the first file) -> they keep external linkage
+            if (sourceManager.getFileID(insertLocation) != sourceManager.getMainFileID())
+            {
+                DBG << "keep external linkage of " << this->getEmittedName(Declaration) << " (declared in a header)" << std::endl;
+            }
+            else if (this->isAlwaysInlined(Declaration))
+            {
+                strRewrittenText << "static inline __attribute__((always_inline)) ";
+            }
+            else if (this->arguments.InternalLinkage)
+            {
+                strRewrittenText << "static ";
+            }
+        }
+
+        // if function is a constructor, we have to add the return type before it
+        if (isa<CXXConstructorDecl>(Declaration))
+        {
+            CXXConstructorDecl *constructorDeclaration = cast<CXXConstructorDecl>(Declaration);
+            CXXRecordDecl *parent = constructorDeclaration->getParent();
+
+            // get name of parent
+            std::string parentName;
+            if (isa<ClassTemplateSpecializationDecl>(parent))
+            {
+                // parent is a class template specialization
+                // -> get mangled name
+                parentName = PatosNameMangling::getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(parent));
+            }
+            else
+            {
+                // parent is a 'normal' record
+                parentName = parent->getNameAsString();
+            }
+
+            // add return type
+            // (the in-place variant initializes the record its first parameter points to)
+            if (this->currentConstructorInPlace)
+            {
+                strRewrittenText << "void ";
+            }
+            else
+            {
+                strRewrittenText << "struct " << parentName << " ";
+            }
+        }
+
+        // rewritten code of signature
+        std::string signatureSource = this->currentRewriter->getRewrittenText(getSignatureSourceRange(Declaration));
+        strRewrittenText << signatureSource;
+
+        // add declaration to source
+        std::string declarationSource = strRewrittenText.str() + ";\n";
+        this->emitCode(insertLocation, declarationSource, this->getEmittedName(Declaration), CODE_PROTOTYPE);
+
+        // code of (non-template) methods of a class template specialization is accounted to the specialization
+        std::string codeOwner = this->getOutputName(Declaration);
+        if (isa<CXXMethodDecl>(Declaration) &&
+            isa<ClassTemplateSpecializationDecl>(cast<CXXMethodDecl>(Declaration)->getParent()) &&
+            Declaration->getTemplatedKind() != FunctionDecl::TemplatedKind::TK_FunctionTemplateSpecialization)
+        {
+            codeOwner = this->getOutputName(cast<CXXMethodDecl>(Declaration)->getParent());
+        }
+
+        this->addGeneratedCode(codeOwner, declarationSource.size());
+
+        // rewritten code of body (if any)
+        if (addDefinitionToMainFile && Declaration->hasBody())
+        {
+            this->eliminateRecursion(Declaration);
+
+            std::string bodySource = this->currentRewriter->getRewrittenText(Declaration->getBody()->getSourceRange());
+
+            if (this->arguments.FoldIdentical && this->foldIdenticalDefinition(Declaration, signatureSource, bodySource))
+            {
+                DBG << "folded definition of " << this->getEmittedName(Declaration) << std::endl;
+            }
+
+            strRewrittenText << "\n" << bodySource << "\n";
+
+            // this is a definition
+            // definitions have to be added to the _module_, i.e. we have to insert it in the main file
+            SourceLocation locationModule = this->context->getSourceManager().getLocForEndOfFile(this->context->getSourceManager().getMainFileID());
+            this->emitCode(locationModule, strRewrittenText.str(), this->getEmittedName(Declaration), CODE_DEFINITION);
+
+            this->addGeneratedCode(codeOwner, strRewrittenText.str().size());
+        }
+    }
+}
+
+// if an identical definition (same signature except for the name, same body) has already been emitted,
+// the body is replaced by a call to this definition
+bool PassTransformation::foldIdenticalDefinition(FunctionDecl *Declaration, const std::string &signatureSource, std::string &bodySource)
+{
+    // kernels are entry points and constructors return their own record -> never fold them
+    // (neither methods working on a struct of arrays, which do not have an instance pointer)
+    if (isKernelFunction(Declaration) || isa<CXXConstructorDecl>(Declaration) ||
+        (this->currentClone != NULL && this->currentClone->StructOfArraysRecord != NULL))
+    {
+        return false;
+    }
+
+    std::string mangledName = this->getEmittedName(Declaration);
+
+    std::string key = signatureSource;
+    std::string::size_type posName = key.find(mangledName);
+    if (posName == std::string::npos)
+    {
+        return false;
+    }
+    key.replace(posName, mangledName.size(), "@");
+
+    // methods not accessing their instance can share the definition with methods of other records
+    // NOTE: an instance passed by value cannot be cast to another record
+    std::string recordName;
+    if (isa<CXXMethodDecl>(Declaration) && bodySource.find("thisRef") == std::string::npos &&
+        !this->passesInstanceByValue(cast<CXXMethodDecl>(Declaration)))
+    {
+        std::string parentName = this->getOutputName(cast<CXXMethodDecl>(Declaration)->getParent());
+        std::string thisRefParameter = "struct " + parentName + " *thisRef";
+
+        std::string::size_type posThisRef = key.find(thisRefParameter);
+        if (posThisRef != std::string::npos)
+        {
+            key.replace(posThisRef, thisRefParameter.size(), "@thisRef");
+            recordName = parentName;
+        }
+    }
+
+    key += "\n" + bodySource;
+
+    auto itFolded = this->foldedDefinitions.find(key);
+    if (itFolded == this->foldedDefinitions.end())
+    {
+        // first definition of its kind
+        this->foldedDefinitions[key] = std::make_pair(mangledName, recordName);
+        return false;
+    }
+
+    // the duplicate now requires the first definition
+    this->references[mangledName].insert(itFolded->second.first);
+
+    // build forwarding call
+    std::stringstream forwardingCall;
+    forwardingCall << itFolded->second.first << "(";
+    {
+        bool firstArgument = true;
+
+        if (isa<CXXMethodDecl>(Declaration) && this->needsInstance(cast<CXXMethodDecl>(Declaration)))
+        {
+            if (!recordName.empty())
+            {
+                // a cast cannot change the address space of the instance
+                std::string addressSpace;
+                if (this->currentClone != NULL && this->currentClone->ThisAddressSpace != PATOS_PRIVATE_ADDRESS_SPACE)
+                {
+                    addressSpace = this->currentClone->ThisAddressSpace + " ";
+                }
+
+                forwardingCall << "(" << addressSpace << "struct " << itFolded->second.second << " *)thisRef";
+            }
+            else if (this->passesInstanceByValue(cast<CXXMethodDecl>(Declaration)))
+            {
+                forwardingCall << "thisVal";
+            }
+            else
+            {
+                forwardingCall << "thisRef";
+            }
+
+            firstArgument = false;
+        }
+
+        for (unsigned idx = 0; idx < Declaration->getNumParams(); ++idx)
+        {
+            std::string parameterName = Declaration->getParamDecl(idx)->getNameAsString();
+            if (parameterName.empty())
+            {
+                // unnamed parameter -> cannot forward
+                return false;
+            }
+
+            forwardingCall << (firstArgument ? "" : ", ") << parameterName;
+            firstArgument = false;
+        }
+    }
+    forwardingCall << ")";
+
+    if (Declaration->getReturnType()->isVoidType())
+    {
+        bodySource = "{\n\t" + forwardingCall.str() + ";\n}";
+    }
+    else
+    {
+        bodySource = "{\n\treturn " + forwardingCall.str() + ";\n}";
+    }
+
+    return true;
+}
+
+bool PassTransformation::hasAlreadyADeclaration(const std::string &declarationName)
+{
+    // iterate over all declarations in the AST
+    TranslationUnitDecl *translationUnit = this->context->getTranslationUnitDecl();
+    for (auto it = translationUnit->decls_begin(); it != translationUnit->decls_end(); ++it)
+    {
+        Decl *otherDeclaration = *it;
+
+        if (isa<NamedDecl>(otherDeclaration))
+        {
+            if (cast<NamedDecl>(otherDeclaration)->getNameAsString() == declarationName)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// NOTE: this method returns a source range *including* the opening parenthesis of the call expression
+// (possibly followed by some whitespace)
+SourceRange PassTransformation::getRealCalleeSourceRange(const CallExpr *Expression)
+{
+    // get source range for callee
+    // unfortunately, clang provides the wrong range for our purpose if explicit template arguments are specified:
+    //    foo<bar>()
+    //    ^~^ clang only provides this source range
+
+    SourceLocation locationBegin = Expression->getCallee()->getLocStart();
+
+    SourceLocation locationEnd;
+    
+    if (Expression->getNumArgs() > 0)
+    {
+        locationEnd = Expression->getArg(0)->getLocStart().getLocWithOffset(-1);
+    }
+    else
+    {
+        locationEnd = Expression->getRParenLoc().getLocWithOffset(-1);
+    }
+
+    return SourceRange(locationBegin, locationEnd);
+}
+
+SourceRange PassTransformation::getDeclaratorSourceRange(FunctionDecl *Declaration)
+{
+    if (isa<CXXMethodDecl>(Declaration))
+    {
+        CXXMethodDecl *MethodDeclaration = cast<CXXMethodDecl>(Declaration);
+
+        if (MethodDeclaration->getParent() != MethodDeclaration->getLexicalParent())
+        {
+            // compute source range of 'qualified' declarator
+            //
+            // void FOO::bar()
+            //      ^------^ this is what we want
+            //           ^-^ this is what clang gives us...
+            //
+            // (did not find a better way...)
+
+            const SourceManager &sourceManager = this->context->getSourceManager();
+            const LangOptions &languageOptions = this->context->getLangOpts();
 
             SourceRange returnTypeSourceRange = MethodDeclaration->getReturnTypeSourceRange();
             SourceLocation realReturnTypeEndLocation = Lexer::getLocForEndOfToken(returnTypeSourceRange.getEnd(), 0, sourceManager, languageOptions);
 
-            return SourceRange(realReturnTypeEndLocation.getLocWithOffset(1), MethodDeclaration->getNameInfo().getLocEnd());
+            return SourceRange(realReturnTypeEndLocation.getLocWithOffset(1), MethodDeclaration->getNameInfo().getLocEnd());
+        }
+    }
+
+    return Declaration->getNameInfo().getSourceRange();
+}
+
+// constructor call of a temporary object ('T(...)'), NULL for other expressions
+PRIVATE CXXConstructExpr *getTemporaryConstructExpr(Expr *Expression)
+{
+    if (isa<CXXTemporaryObjectExpr>(Expression))
+    {
+        return cast<CXXTemporaryObjectExpr>(Expression);
+    }
+    else if (isa<CXXFunctionalCastExpr>(Expression))
+    {
+        Expr *subExpression = cast<CXXFunctionalCastExpr>(Expression)->getSubExpr()->IgnoreImplicit();
+        if (isa<CXXConstructExpr>(subExpression))
+        {
+            return cast<CXXConstructExpr>(subExpression);
+        }
+    }
+
+    return NULL;
+}
+
+// temporary of a value type constructed by a user-defined constructor, which is replaced by
+// the call to the 'constructor' function (instead of a helper variable)
+PRIVATE bool isValueTemporary(Expr *Expression)
+{
+    CXXConstructExpr *constructExpression = getTemporaryConstructExpr(Expression);
+
+    return constructExpression != NULL && !constructExpression->getConstructor()->isImplicit() &&
+           isValueTypeRecord(constructExpression->getConstructor()->getParent());
+}
+
+// default-constructed temporary of an empty record (e.g. 'COMP()'), which does not have to exist
+// if a method is called on it
+PRIVATE bool isElidableTemporary(Expr *Expression)
+{
+    CXXConstructExpr *constructExpression = getTemporaryConstructExpr(Expression->IgnoreImplicit()->IgnoreParens());
+
+    if (constructExpression == NULL || constructExpression->getNumArgs() > 0)
+    {
+        return false;
+    }
+
+    CXXConstructorDecl *constructorDeclaration = constructExpression->getConstructor();
+
+    return constructorDeclaration != NULL && isEmptyRecord(constructorDeclaration->getParent()) &&
+           (constructorDeclaration->isImplicit() || constructorDeclaration->hasTrivialBody());
+}
+
+// instance of a method of an empty record that does not have to be evaluated (i.e. it is dropped from the call)
+PRIVATE bool isDroppableInstance(Expr *Instance, const ASTContext &context)
+{
+    return isElidableTemporary(Instance) || !Instance->HasSideEffects(context);
+}
+
+class ASTVisitorTemporaryObject: public RecursiveASTVisitor<ASTVisitorTemporaryObject>
+{
+private:
+    bool foundTemporaryObject;
+    std::vector<Expr *> *result;
+
+    // temporaries of empty records methods are called on (need not be created)
+    std::set<Expr *> elidedTemporaryObjects;
+
+    // temporaries of value types methods are called on, along with the method
+    std::map<Expr *, CXXMethodDecl *> valueTemporaryInstances;
+
+    bool isUsedAsTemporaryObject(Expr *Expression)
+    {
+        if (this->elidedTemporaryObjects.find(Expression) != this->elidedTemporaryObjects.end())
+        {
+            return false;
+        }
+
+        // other temporaries of value types are replaced by the constructor call
+        return !isValueTemporary(Expression) || this->valueTemporaryInstances.find(Expression) != this->valueTemporaryInstances.end();
+    }
+
+public:
+    bool usesTemporaryObject(Stmt *Statement, std::vector<Expr *> &result)
+    {
+        this->foundTemporaryObject = false;
+        this->result = &result;
+        this->elidedTemporaryObjects.clear();
+        this->valueTemporaryInstances.clear();
+
+        this->TraverseStmt(Statement);
+
+        return this->foundTemporaryObject;
+    }
+
+    // method called on a temporary of a value type (NULL if the temporary is used otherwise)
+    CXXMethodDecl *getMethodCalledOnValueTemporary(Expr *Expression)
+    {
+        auto it = this->valueTemporaryInstances.find(Expression);
+
+        return (it != this->valueTemporaryInstances.end()) ? it->second : NULL;
+    }
+
+    // NOTE: calls are visited before their arguments
+    bool VisitCXXOperatorCallExpr(CXXOperatorCallExpr *Expression)
+    {
+        if (Expression->getCalleeDecl() != NULL && isa<CXXMethodDecl>(Expression->getCalleeDecl()) && Expression->getNumArgs() > 0)
+        {
+            Expr *instance = Expression->getArg(0)->IgnoreImplicit()->IgnoreParens();
+
+            if (isElidableTemporary(instance))
+            {
+                this->elidedTemporaryObjects.insert(instance);
+            }
+            else if (isValueTemporary(instance))
+            {
+                this->valueTemporaryInstances[instance] = cast<CXXMethodDecl>(Expression->getCalleeDecl());
+            }
+        }
+
+        return true;
+    }
+
+    bool VisitCXXMemberCallExpr(CXXMemberCallExpr *Expression)
+    {
+        if (isa<MemberExpr>(Expression->getCallee()))
+        {
+            Expr *base = cast<MemberExpr>(Expression->getCallee())->getBase()->IgnoreImplicit()->IgnoreParens();
+
+            if (isElidableTemporary(base))
+            {
+                this->elidedTemporaryObjects.insert(base);
+            }
+            else if (isValueTemporary(base) && Expression->getMethodDecl() != NULL)
+            {
+                this->valueTemporaryInstances[base] = Expression->getMethodDecl();
+            }
+        }
+
+        return true;
+    }
+
+    bool TraverseCompoundStmt(CompoundStmt *Statement)
+    {
+        // NOTE: we do not want to find temporary objects in nested compound statements
+        // -> do not traverse compound statement
+
+        return true;
+    }
+
+    bool VisitCXXFunctionalCastExpr(CXXFunctionalCastExpr *Expression)
+    {
+        if (!this->isUsedAsTemporaryObject(Expression))
+        {
+            return true;
+        }
+
+        this->foundTemporaryObject = true;
+        this->result->push_back(Expression);
+
+        return true;
+    }
+
+    bool VisitCXXTemporaryObjectExpr(CXXTemporaryObjectExpr *Expression)
+    {
+        if (!this->isUsedAsTemporaryObject(Expression))
+        {
+            return true;
+        }
+
+        this->foundTemporaryObject = true;
+        this->result->push_back(Expression);
+
+        return true;
+    }
+};
+
+bool PassTransformation::findUsagesOfTemporaryObjects(Stmt *Statement, std::vector<Expr *> &result)
+{
+    // sooo meta!
+    ASTVisitorTemporaryObject visitor;
+
+    std::vector<Expr *> temporaryObjects;
+    visitor.usesTemporaryObject(Statement, temporaryObjects);
+
+    // a temporary of a value type is only replaced by the constructor call if the method called on it
+    // gets the instance by value, otherwise it needs an address (i.e. a helper variable)
+    for (auto it = temporaryObjects.begin(); it != temporaryObjects.end(); ++it)
+    {
+        CXXMethodDecl *method = visitor.getMethodCalledOnValueTemporary(*it);
+
+        if (method == NULL || !this->passesInstanceByValue(method))
+        {
+            result.push_back(*it);
+        }
+    }
+
+    return !result.empty();
+}
+
+std::string PassTransformation::getNameForTemporaryObject(Expr *Expression)
+{
+    if (this->temporaryObjectNames.find(Expression) != this->temporaryObjectNames.end())
+    {
+        return this->temporaryObjectNames[Expression];
+    }
+
+    std::string temporaryName = "__patos_temporary_" + std::to_string(this->temporaryObjectCounter++);
+    this->temporaryObjectNames[Expression] = temporaryName;
+
+    return temporaryName;
+}
+
+void PassTransformation::getSpecializations(ClassTemplateDecl *Declaration, std::vector<ClassTemplateSpecializationDecl *> &result)
+{
+    std::vector<std::pair<std::string, ClassTemplateSpecializationDecl *>> specializations;
+
+    for (auto it = Declaration->spec_begin(); it != Declaration->spec_end(); ++it)
+    {
+        specializations.push_back(std::make_pair(PatosNameMangling::getMangledNameForRecord(*it), *it));
+    }
+
+    // spec_begin() yields the specializations in the order in which they have been instantiated
+    // -> sort by mangled name to get a canonical order
+    if (this->arguments.Reproducible)
+    {
+        std::stable_sort(specializations.begin(), specializations.end(),
+            [](const std::pair<std::string, ClassTemplateSpecializationDecl *> &a, const std::pair<std::string, ClassTemplateSpecializationDecl *> &b)
+            {
+                return a.first < b.first;
+            });
+    }
+
+    for (auto it = specializations.begin(); it != specializations.end(); ++it)
+    {
+        result.push_back(it->second);
+    }
+}
+
+void PassTransformation::getSpecializations(FunctionTemplateDecl *Declaration, std::vector<FunctionDecl *> &result)
+{
+    std::vector<std::pair<std::string, FunctionDecl *>> specializations;
+
+    for (auto it = Declaration->spec_begin(); it != Declaration->spec_end(); ++it)
+    {
+        specializations.push_back(std::make_pair(PatosNameMangling::getMangledNameForFunction(*it), *it));
+    }
+
+    // see above
+    if (this->arguments.Reproducible)
+    {
+        std::stable_sort(specializations.begin(), specializations.end(),
+            [](const std::pair<std::string, FunctionDecl *> &a, const std::pair<std::string, FunctionDecl *> &b)
+            {
+                return a.first < b.first;
+            });
+    }
+
+    for (auto it = specializations.begin(); it != specializations.end(); ++it)
+    {
+        result.push_back(it->second);
+    }
+}
+
+bool PassTransformation::hasAlreadyATypeDef(const std::string &recordName)
+{
+    TranslationUnitDecl *translationUnit = this->context->getTranslationUnitDecl();
+
+    for (auto it = translationUnit->decls_begin(); it != translationUnit->decls_end(); ++it)
+    {
+        Decl *declaration = *it;
+
+        if (isa<TypedefDecl>(declaration) && cast<TypedefDecl>(declaration)->getNameAsString() == recordName)
+            return true;
+    }
+
+    return false;
+}
+
+std::string PassTransformation::getSourceLine(SourceLocation location)
+{
+    SourceManager &sourceManager = this->context->getSourceManager();
+
+    std::pair<FileID, unsigned> decomposedLocation = sourceManager.getDecomposedLoc(sourceManager.getExpansionLoc(location));
+    std::string buffer = sourceManager.getBufferData(decomposedLocation.first).str();
+
+    std::string::size_type begin = buffer.rfind('\n', decomposedLocation.second);
+    begin = (begin == std::string::npos) ? 0 : begin + 1;
+
+    std::string::size_type end = buffer.find('\n', decomposedLocation.second);
+
+    return buffer.substr(begin, (end == std::string::npos) ? std::string::npos : end - begin);
+}
+
+std::string PassTransformation::getOutputName(RecordDecl *Declaration)
+{
+    if (isa<ClassTemplateSpecializationDecl>(Declaration))
+    {
+        return PatosNameMangling::getMangledNameForRecord(cast<ClassTemplateSpecializationDecl>(Declaration));
+    }
+
+    return Declaration->getNameAsString();
+}
+
+std::string PassTransformation::getOutputName(FunctionDecl *Declaration)
+{
+    // see VisitFunctionDecl()
+    if (Declaration->getTemplatedKind() == FunctionDecl::TemplatedKind::TK_FunctionTemplateSpecialization ||
+        isa<CXXMethodDecl>(Declaration))
+    {
+        return PatosNameMangling::getMangledNameForFunction(Declaration);
+    }
+
+    return Declaration->getNameAsString();
+}
+
+std::string PassTransformation::getEmittedName(FunctionDecl *Declaration)
+{
+    // clones of a function carry the address spaces in their name
+    if (this->currentClone != NULL)
+    {
+        return this->getOutputName(Declaration) + this->currentClone->Suffix;
+    }
+
+    if (this->currentConstructorInPlace)
+    {
+        return this->getOutputName(Declaration) + "_inplace";
+    }
+
+    return this->getOutputName(Declaration);
+}
+
+std::string PassTransformation::getAnnotatedAddressSpace(const Decl *Declaration)
+{
+    static const char *addressSpaces[] = { "__global", "__local", "__constant", "__private" };
+
+    for (auto it = Declaration->attr_begin(); it != Declaration->attr_end(); ++it)
+    {
+        const Attr *attribute = *it;
+
+        if (!isa<AnnotateAttr>(attribute))
+        {
+            continue;
+        }
+
+        std::string annotation = cast<AnnotateAttr>(attribute)->getAnnotation().str();
+        for (unsigned idx = 0; idx < sizeof(addressSpaces) / sizeof(addressSpaces[0]); ++idx)
+        {
+            if (annotation == std::string(PATOS_ANNOTATION_PREFIX) + addressSpaces[idx])
+            {
+                return addressSpaces[idx];
+            }
+        }
+    }
+
+    // the annotations of parameters are not always instantiated with the function template
+    // -> look at the parameter of the template
+    if (isa<ParmVarDecl>(Declaration) && isa<FunctionDecl>(Declaration->getDeclContext()))
+    {
+        const ParmVarDecl *parameter = cast<ParmVarDecl>(Declaration);
+        const FunctionDecl *function = cast<FunctionDecl>(Declaration->getDeclContext());
+        const FunctionDecl *pattern = function->getTemplateInstantiationPattern();
+
+        if (pattern != NULL && pattern != function && parameter->getFunctionScopeIndex() < pattern->getNumParams())
+        {
+            return this->getAnnotatedAddressSpace(pattern->getParamDecl(parameter->getFunctionScopeIndex()));
+        }
+    }
+
+    return "";
+}
+
+// address space of the memory the given pointer expression points into
+std::string PassTransformation::inferAddressSpace(const Expr *Expression)
+{
+    Expression = Expression->IgnoreParens();
+
+    if (isa<ImplicitCastExpr>(Expression))
+    {
+        const ImplicitCastExpr *castExpression = cast<ImplicitCastExpr>(Expression);
+
+        // arrays decay to pointers into their own storage
+        if (castExpression->getCastKind() == CK_ArrayToPointerDecay)
+        {
+            return this->inferStorageAddressSpace(castExpression->getSubExpr());
+        }
+
+        return this->inferAddressSpace(castExpression->getSubExpr());
+    }
+
+    // casts cannot change the address space
+    if (isa<ExplicitCastExpr>(Expression))
+    {
+        return this->inferAddressSpace(cast<ExplicitCastExpr>(Expression)->getSubExpr());
+    }
+
+    if (isa<CXXThisExpr>(Expression))
+    {
+        if (this->currentClone != NULL && !this->currentClone->ThisAddressSpace.empty())
+        {
+            return this->currentClone->ThisAddressSpace;
+        }
+
+        return PATOS_PRIVATE_ADDRESS_SPACE;
+    }
+
+    if (isa<DeclRefExpr>(Expression))
+    {
+        const ValueDecl *declaration = cast<DeclRefExpr>(Expression)->getDecl();
+
+        auto itInferred = this->pointerAddressSpaces.find(declaration);
+        if (itInferred != this->pointerAddressSpaces.end())
+        {
+            return itInferred->second;
+        }
+
+        std::string addressSpace = this->getAnnotatedAddressSpace(declaration);
+        return addressSpace.empty() ? PATOS_PRIVATE_ADDRESS_SPACE : addressSpace;
+    }
+
+    if (isa<UnaryOperator>(Expression))
+    {
+        const UnaryOperator *unaryOperator = cast<UnaryOperator>(Expression);
+
+        if (unaryOperator->getOpcode() == UO_AddrOf)
+        {
+            return this->inferStorageAddressSpace(unaryOperator->getSubExpr());
+        }
+
+        if (unaryOperator->isIncrementDecrementOp())
+        {
+            return this->inferAddressSpace(unaryOperator->getSubExpr());
+        }
+    }
+
+    if (isa<BinaryOperator>(Expression))
+    {
+        const BinaryOperator *binaryOperator = cast<BinaryOperator>(Expression);
+
+        // pointer arithmetic stays in the address space of the pointer operand
+        if (binaryOperator->isAdditiveOp())
+        {
+            if (binaryOperator->getLHS()->getType()->isPointerType())
+            {
+                return this->inferAddressSpace(binaryOperator->getLHS());
+            }
+
+            return this->inferAddressSpace(binaryOperator->getRHS());
+        }
+
+        if (binaryOperator->isAssignmentOp())
+        {
+            return this->inferAddressSpace(binaryOperator->getLHS());
+        }
+
+        if (binaryOperator->getOpcode() == BO_Comma)
+        {
+            return this->inferAddressSpace(binaryOperator->getRHS());
+        }
+    }
+
+    if (isa<ConditionalOperator>(Expression))
+    {
+        const ConditionalOperator *conditionalOperator = cast<ConditionalOperator>(Expression);
+
+        std::string addressSpaceTrue = this->inferAddressSpace(conditionalOperator->getTrueExpr());
+        std::string addressSpaceFalse = this->inferAddressSpace(conditionalOperator->getFalseExpr());
+
+        if (addressSpaceTrue == addressSpaceFalse)
+        {
+            return addressSpaceTrue;
+        }
+    }
+
+    return PATOS_PRIVATE_ADDRESS_SPACE;
+}
+
+// address space of the memory the given lvalue expression is stored in
+std::string PassTransformation::inferStorageAddressSpace(const Expr *Expression)
+{
+    Expression = Expression->IgnoreParenImpCasts();
+
+    if (isa<DeclRefExpr>(Expression))
+    {
+        const ValueDecl *declaration = cast<DeclRefExpr>(Expression)->getDecl();
+
+        // the annotation of a pointer refers to the memory it points into, not to the pointer itself
+        if (declaration->getType()->isPointerType())
+        {
+            return PATOS_PRIVATE_ADDRESS_SPACE;
+        }
+
+        std::string addressSpace = this->getAnnotatedAddressSpace(declaration);
+        return addressSpace.empty() ? PATOS_PRIVATE_ADDRESS_SPACE : addressSpace;
+    }
+
+    if (isa<ArraySubscriptExpr>(Expression))
+    {
+        return this->inferAddressSpace(cast<ArraySubscriptExpr>(Expression)->getBase());
+    }
+
+    if (isa<UnaryOperator>(Expression) && cast<UnaryOperator>(Expression)->getOpcode() == UO_Deref)
+    {
+        return this->inferAddressSpace(cast<UnaryOperator>(Expression)->getSubExpr());
+    }
+
+    if (isa<MemberExpr>(Expression))
+    {
+        const MemberExpr *memberExpression = cast<MemberExpr>(Expression);
+
+        if (memberExpression->isArrow())
+        {
+            return this->inferAddressSpace(memberExpression->getBase());
+        }
+
+        return this->inferStorageAddressSpace(memberExpression->getBase());
+    }
+
+    return PATOS_PRIVATE_ADDRESS_SPACE;
+}
+
+// returns the name of the function to call for the given callee, i.e. the name of its clone
+// for the address spaces of the arguments (which is requested to be emitted) if it is not
+// called with private pointers only
+std::string PassTransformation::getCalleeName(FunctionDecl *Callee, const std::string &thisAddressSpace, const std::vector<const Expr *> &arguments)
+{
+    std::string calleeName = this->getOutputName(Callee);
+
+    // kernels are not called from device code and constructors do not have an instance pointer
+    // NOTE: functions without a definition (e.g. built-ins) cannot be cloned
+    if (isInSystemFile(Callee) || this->isKernelFunction(Callee) || isa<CXXConstructorDecl>(Callee) || !Callee->isDefined())
+    {
+        return calleeName;
+    }
+
+    AddressSpaceClone clone;
+    clone.Declaration = Callee;
+    clone.StructOfArraysRecord = NULL;
+    // NOTE: the address space of an instance passed by value does not matter
+    clone.ThisAddressSpace = "";
+    if (isa<CXXMethodDecl>(Callee) && this->needsInstance(cast<CXXMethodDecl>(Callee)) &&
+        !this->passesInstanceByValue(cast<CXXMethodDecl>(Callee)))
+    {
+        clone.ThisAddressSpace = thisAddressSpace;
+    }
+
+    bool hasNonPrivateAddressSpace = false;
+
+    std::stringstream suffix;
+    if (!clone.ThisAddressSpace.empty())
+    {
+        suffix << clone.ThisAddressSpace[2];
+        hasNonPrivateAddressSpace = (clone.ThisAddressSpace != PATOS_PRIVATE_ADDRESS_SPACE);
+    }
+
+    for (unsigned idx = 0; idx < Callee->getNumParams() && idx < arguments.size(); ++idx)
+    {
+        ParmVarDecl *parameter = Callee->getParamDecl(idx);
+
+        // only pointers without an explicit address space are cloned
+        if (!parameter->getType()->isPointerType() || !this->getAnnotatedAddressSpace(parameter).empty())
+        {
+            clone.ParameterAddressSpaces.push_back("");
+            continue;
+        }
+
+        std::string addressSpace = this->inferAddressSpace(arguments[idx]);
+        clone.ParameterAddressSpaces.push_back(addressSpace);
+
+        // first letter of the address space: g(lobal), l(ocal), c(onstant), p(rivate)
+        suffix << addressSpace[2];
+        hasNonPrivateAddressSpace = hasNonPrivateAddressSpace || (addressSpace != PATOS_PRIVATE_ADDRESS_SPACE);
+    }
+
+    if (!hasNonPrivateAddressSpace)
+    {
+        return calleeName;
+    }
+
+    clone.Suffix = "_AS" + suffix.str();
+    std::string cloneName = calleeName + clone.Suffix;
+
+    if (this->requestedClones.find(cloneName) == this->requestedClones.end())
+    {
+        DBG << "         request address space clone " << cloneName << std::endl;
+
+        this->requestedClones[cloneName] = clone;
+        this->cloneWorklist.push_back(cloneName);
+    }
+
+    this->addReference(cloneName);
+
+    return cloneName;
+}
+
+void PassTransformation::emitAddressSpaceClone(const AddressSpaceClone &clone)
+{
+    FunctionDecl *declaration = clone.Declaration;
+
+    std::string cloneName = this->getOutputName(declaration) + clone.Suffix;
+    if (this->hasAlreadyADeclaration(cloneName))
+    {
+        return;
+    }
+
+    DBG << "emit address space clone " << cloneName << std::endl;
+
+    // the prototype goes where the original prototype has been emitted (i.e. before any call),
+    // whereas the signature and the body are taken from the definition
+    SourceLocation insertLocation;
+    if (isa<CXXMethodDecl>(declaration))
+    {
+        SourceManager &sourceManager = this->context->getSourceManager();
+        const LangOptions &languageOptions = this->context->getLangOpts();
+
+        insertLocation = Lexer::findLocationAfterToken(cast<CXXMethodDecl>(declaration)->getParent()->getLocEnd(), tok::semi, sourceManager, languageOptions, true);
+    }
+    else
+    {
+        insertLocation = getRealEndLocationForFunctionDeclaration(declaration->getFirstDecl());
+    }
+
+    FunctionDecl *definition = declaration->getDefinition();
+    if (definition == NULL)
+    {
+        definition = declaration;
+    }
+
+    // save old state
+    // NOTE: the address spaces of the parameters (and local pointers) are only valid for this clone
+    Rewriter *oldRewriter = this->currentRewriter;
+    const AddressSpaceClone *oldClone = this->currentClone;
+    std::map<const ValueDecl *, std::string> oldPointerAddressSpaces = this->pointerAddressSpaces;
+
+    // create a new rewriter for the clone
+    Rewriter cloneRewriter;
+    cloneRewriter.setSourceMgr(this->context->getSourceManager(), this->context->getLangOpts());
+    this->currentRewriter = &cloneRewriter;
+    this->currentClone = &clone;
+
+    // pointer parameters point into the address spaces of the arguments
+    // (parameters without an argument, e.g. defaulted ones, keep their annotated address space)
+    for (unsigned idx = 0; idx < definition->getNumParams(); ++idx)
+    {
+        ParmVarDecl *parameter = definition->getParamDecl(idx);
+        std::string addressSpace = (idx < clone.ParameterAddressSpaces.size()) ? clone.ParameterAddressSpaces[idx] : "";
+
+        if (addressSpace.empty())
+        {
+            this->pointerAddressSpaces.erase(parameter);
+            continue;
+        }
+
+        this->pointerAddressSpaces[parameter] = addressSpace;
+
+        if (addressSpace != PATOS_PRIVATE_ADDRESS_SPACE)
+        {
+            cloneRewriter.InsertTextBefore(parameter->getLocStart(), addressSpace + " ");
+        }
+    }
+
+    this->transformFunction(definition, insertLocation, definition->doesThisDeclarationHaveABody());
+
+    // restore old state
+    this->currentRewriter = oldRewriter;
+    this->currentClone = oldClone;
+    this->pointerAddressSpaces = oldPointerAddressSpaces;
+}
+
+bool PassTransformation::isStructOfArraysRecord(const CXXRecordDecl *Declaration)
+{
+    if (hasAnnotation(Declaration, PATOS_SOA_ANNOTATION))
+    {
+        return true;
+    }
+
+    // specializations of an annotated class template
+    if (isa<ClassTemplateSpecializationDecl>(Declaration))
+    {
+        ClassTemplateDecl *classTemplate = cast<ClassTemplateSpecializationDecl>(Declaration)->getSpecializedTemplate();
+
+        return hasAnnotation(classTemplate->getTemplatedDecl(), PATOS_SOA_ANNOTATION);
+    }
+
+    return false;
+}
+
+// returns the record, if the given type is a pointer to a record annotated with '__soa' (NULL otherwise)
+const CXXRecordDecl *PassTransformation::getStructOfArraysPointee(QualType type)
+{
+    if (!type->isPointerType())
+    {
+        return NULL;
+    }
+
+    const CXXRecordDecl *record = type->getPointeeType()->getAsCXXRecordDecl();
+    if (record == NULL || !record->hasDefinition() || !this->isStructOfArraysRecord(record))
+    {
+        return NULL;
+    }
+
+    return record->getDefinition();
+}
+
+// one pointer parameter per field: 'T *items' -> 'float *items_x, float *items_y'
+std::string PassTransformation::getStructOfArraysParameters(const CXXRecordDecl *Record, const std::string &prefix, const std::string &addressSpace, bool isConst)
+{
+    std::stringstream parameters;
+
+    for (auto it = Record->field_begin(); it != Record->field_end(); ++it)
+    {
+        QualType fieldType = it->getType();
+
+        if (fieldType->isRecordType() || fieldType->isArrayType())
+        {
+            FAIL("field '" << it->getNameAsString() << "' of record '" << Record->getNameAsString() << "' cannot be split into an array "
+                 "(struct of arrays supports scalar, vector and pointer fields only)");
+        }
+
+        parameters << (it == Record->field_begin() ? "" : ", ")
+                   << addressSpace << " " << (isConst ? "const " : "") << getOutputTypeSpelling(fieldType) << " *" << prefix << "_" << it->getNameAsString();
+    }
+
+    return parameters.str();
+}
+
+// arguments for a method called on an element of a struct of arrays: the arrays and the index of the element
+std::string PassTransformation::getStructOfArraysArguments(const CXXRecordDecl *Record, const std::string &prefix, const std::string &index)
+{
+    std::stringstream arguments;
+
+    for (auto it = Record->field_begin(); it != Record->field_end(); ++it)
+    {
+        arguments << prefix << "_" << it->getNameAsString() << ", ";
+    }
+
+    arguments << index;
+
+    return arguments.str();
+}
+
+// checks if the base of the given member expression is an element of a struct of arrays,
+// i.e. 'items[i].', 'items->' (items being split) or 'this->' (in a method called on such an element)
+// NOTE: the index expression is transformed by this method
+bool PassTransformation::getStructOfArraysElement(MemberExpr *Expression, std::string &prefix, std::string &index, std::string &addressSpace)
+{
+    Expr *base = Expression->getBase()->IgnoreParenImpCasts();
+
+    if (Expression->isArrow())
+    {
+        if (isa<CXXThisExpr>(base) && this->currentClone != NULL && this->currentClone->StructOfArraysRecord != NULL)
+        {
+            prefix = "thisRef";
+            index = "thisIdx";
+            addressSpace = this->currentClone->StructOfArraysAddressSpace;
+            return true;
+        }
+
+        if (isa<DeclRefExpr>(base))
+        {
+            auto it = this->structOfArraysParameters.find(cast<DeclRefExpr>(base)->getDecl());
+            if (it != this->structOfArraysParameters.end())
+            {
+                prefix = it->first->getNameAsString();
+                index = "0";
+                addressSpace = it->second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    if (isa<ArraySubscriptExpr>(base))
+    {
+        ArraySubscriptExpr *subscript = cast<ArraySubscriptExpr>(base);
+        Expr *array = subscript->getBase()->IgnoreParenImpCasts();
+
+        if (isa<DeclRefExpr>(array))
+        {
+            auto it = this->structOfArraysParameters.find(cast<DeclRefExpr>(array)->getDecl());
+            if (it != this->structOfArraysParameters.end())
+            {
+                TraverseStmt(subscript->getIdx());
+
+                prefix = it->first->getNameAsString();
+                index = this->expressionToString(subscript->getIdx());
+                addressSpace = it->second;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// returns the name of the clone of the given method working on an element of a struct of arrays
+// (which is requested to be emitted)
+std::string PassTransformation::requestStructOfArraysClone(CXXMethodDecl *Method, const std::string &addressSpace)
+{
+    if (Method->isStatic() || !Method->isDefined())
+    {
+        FAIL("method '" << Method->getNameAsString() << "' cannot be called on an element of a struct of arrays");
+    }
+
+    AddressSpaceClone clone;
+    clone.Declaration = Method;
+    clone.StructOfArraysRecord = Method->getParent();
+    clone.StructOfArraysAddressSpace = addressSpace;
+    clone.Suffix = "_soa" + addressSpace.substr(2, 1);
+
+    std::string cloneName = this->getOutputName(Method) + clone.Suffix;
+
+    if (this->requestedClones.find(cloneName) == this->requestedClones.end())
+    {
+        DBG << "         request struct of arrays clone " << cloneName << std::endl;
+
+        this->requestedClones[cloneName] = clone;
+        this->cloneWorklist.push_back(cloneName);
+    }
+
+    this->addReference(cloneName);
+
+    return cloneName;
+}
+
+void PassTransformation::addReference(const std::string &name)
+{
+    if (!this->currentOwner.empty() && name != this->currentOwner)
+    {
+        this->references[this->currentOwner].insert(name);
+    }
+}
+
+// generated code is inserted right away or, if unreachable code is pruned or kernels are amalgamated,
+// when it is known which functions/records are reachable from the kernels
+void PassTransformation::emitCode(const SourceLocation &location, const std::string &code, const std::string &owner, CodeKind kind, const RecordDecl *record)
+{
+    if (!this->arguments.PruneUnreachable && !this->arguments.Amalgamate)
+    {
+        this->rewriter->InsertTextAfter(location, code);
+        return;
+    }
+
+    PendingCode pending;
+    pending.Location = location;
+    pending.Code = code;
+    pending.Owner = owner;
+    pending.Kind = kind;
+
+    if (record != NULL)
+    {
+        for (auto it = record->field_begin(); it != record->field_end(); ++it)
+        {
+            this->getValueDependencies(it->getType(), pending.Dependencies);
+        }
+    }
+
+    this->pendingCode.push_back(pending);
+}
+
+// records (by output name) an object of the given type contains by value
+void PassTransformation::getValueDependencies(QualType type, std::set<std::string> &dependencies)
+{
+    const Type *typePtr = this->context->getBaseElementType(type).getCanonicalType().getTypePtr();
+
+    if (isa<RecordType>(typePtr))
+    {
+        dependencies.insert(this->getOutputName(cast<RecordType>(typePtr)->getDecl()));
+    }
+}
+
+// typedefs, enums and records a type is spelled with (also through pointers and arrays)
+// NOTE: a typedef is used by its name, the types it refers to are used by the typedef itself
+void PassTransformation::getTypeUses(QualType type, std::set<std::string> &uses)
+{
+    while (!type.isNull())
+    {
+        const Type *typePtr = type.getTypePtr();
+
+        if (isa<TypedefType>(typePtr))
+        {
+            uses.insert(cast<TypedefType>(typePtr)->getDecl()->getNameAsString());
+            return;
+        }
+
+        if (isa<ElaboratedType>(typePtr) || isa<SubstTemplateTypeParmType>(typePtr) || isa<AttributedType>(typePtr) ||
+            isa<ParenType>(typePtr) || isa<AdjustedType>(typePtr))
+        {
+            // other sugar (e.g. 'struct X', template arguments, address spaces) may hide a typedef
+            type = type.getSingleStepDesugaredType(*this->context);
+        }
+        else if (typePtr->isPointerType() || typePtr->isReferenceType())
+        {
+            type = typePtr->getPointeeType();
+        }
+        else if (typePtr->isArrayType())
+        {
+            type = typePtr->getAsArrayTypeUnsafe()->getElementType();
+        }
+        else if (typePtr->getAs<RecordType>() != NULL)
+        {
+            RecordDecl *record = typePtr->getAs<RecordType>()->getDecl();
+
+            if (!record->getName().empty())
+            {
+                uses.insert(this->getOutputName(record));
+            }
+            else if (record->getDefinition() != NULL)
+            {
+                // anonymous records are part of the declaration using them
+                for (auto it = record->getDefinition()->field_begin(); it != record->getDefinition()->field_end(); ++it)
+                {
+                    this->getTypeUses(it->getType(), uses);
+                }
+            }
+
+            return;
+        }
+        else
+        {
+            if (typePtr->getAs<EnumType>() != NULL && !typePtr->getAs<EnumType>()->getDecl()->getName().empty())
+            {
+                uses.insert(typePtr->getAs<EnumType>()->getDecl()->getNameAsString());
+            }
+
+            return;
+        }
+    }
+}
+
+// functions/records reachable from the given ones (including themselves)
+void PassTransformation::getReachable(const std::vector<std::string> &roots, std::set<std::string> &reachable)
+{
+    std::vector<std::string> queue;
+
+    for (auto it = roots.begin(); it != roots.end(); ++it)
+    {
+        if (reachable.insert(*it).second)
+        {
+            queue.push_back(*it);
+        }
+    }
+
+    for (unsigned int idx = 0; idx < queue.size(); ++idx)
+    {
+        auto itReferences = this->references.find(queue[idx]);
+        if (itReferences == this->references.end())
+        {
+            continue;
+        }
+
+        for (auto it = itReferences->second.begin(); it != itReferences->second.end(); ++it)
+        {
+            if (reachable.insert(*it).second)
+            {
+                queue.push_back(*it);
+            }
+        }
+    }
+}
+
+// inserts the pending code (in the order it was emitted), if unreachable code is pruned only the code
+// of the functions/records reachable from the kernels
+// NOTE: declarations kept in place (e.g. typedefs, records without methods) are never pruned
+void PassTransformation::emitPendingCode()
+{
+    // without kernels (e.g. files only included by others), nothing can be pruned
+    if (!this->arguments.PruneUnreachable || this->kernelFunctions.empty())
+    {
+        if (this->arguments.PruneUnreachable)
+        {
+            DBG << "no kernels found, unreachable code is not pruned" << std::endl;
+        }
+
+        for (auto it = this->pendingCode.begin(); it != this->pendingCode.end(); ++it)
+        {
+            this->rewriter->InsertTextAfter(it->Location, it->Code);
+        }
+
+        this->pendingCode.clear();
+        return;
+    }
+
+    std::set<std::string> reachable;
+    this->getReachable(std::vector<std::string>(this->kernelFunctions.begin(), this->kernelFunctions.end()), reachable);
+
+    // NOTE: code inserted into headers is kept, since the original records are removed from them
+    // and other files including them may require the code
+    SourceManager &sourceManager = this->context->getSourceManager();
+
+    std::set<std::string> pruned;
+    for (auto it = this->pendingCode.begin(); it != this->pendingCode.end(); ++it)
+    {
+        if (reachable.find(it->Owner) != reachable.end() || sourceManager.getFileID(it->Location) != sourceManager.getMainFileID())
+        {
+            this->rewriter->InsertTextAfter(it->Location, it->Code);
+        }
+        else if (pruned.insert(it->Owner).second)
+        {
+            DBG << "pruned unreachable " << it->Owner << std::endl;
+        }
+    }
+
+    if (!pruned.empty())
+    {
+        INFO << this->FileName << ": pruned " << pruned.size() << " unreachable function(s)/record(s)" << std::endl;
+    }
+
+    this->pendingCode.clear();
+}
+
+// preprocessor directives of a file and, at the place of their #include, of the files it includes
+// (every file only once, without the #include directives themselves), along with their locations
+PRIVATE void appendDirectives(SourceManager &sourceManager, FileID file, const std::map<std::pair<FileID, unsigned>, std::vector<FileID>> &includes,
+                              std::set<const FileEntry *> &visited, std::vector<std::pair<SourceLocation, std::string>> &result)
+{
+    if (!visited.insert(sourceManager.getFileEntryForID(file)).second)
+    {
+        return;
+    }
+
+    std::istringstream stream(sourceManager.getBufferData(file).str());
+
+    unsigned lineNumber = 0;
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        ++lineNumber;
+        unsigned directiveLine = lineNumber;
+
+        // join continued lines
+        std::string directive;
+        while (true)
+        {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+            {
+                line.erase(line.size() - 1);
+            }
+
+            directive += line;
+
+            if (directive.empty() || directive[directive.size() - 1] != '\\' || !std::getline(stream, line))
+            {
+                break;
+            }
+
+            directive += "\n";
+            ++lineNumber;
+        }
+
+        size_t hashPosition = directive.find_first_not_of(" \t");
+        if (hashPosition == std::string::npos || directive[hashPosition] != '#')
+        {
+            continue;
+        }
+
+        std::istringstream words(directive.substr(hashPosition + 1));
+        std::string name;
+        std::string argument;
+        words >> name >> argument;
+
+        if (name == "include" || name == "include_next" || name == "import")
+        {
+            auto it = includes.find(std::make_pair(file, directiveLine));
+            if (it != includes.end())
+            {
+                for (auto itFile = it->second.begin(); itFile != it->second.end(); ++itFile)
+                {
+                    appendDirectives(sourceManager, *itFile, includes, visited, result);
+                }
+            }
+
+            continue;
+        }
+
+        if (name == "pragma" && argument == "once")
+        {
+            continue;
+        }
+
+        result.push_back(std::make_pair(sourceManager.translateLineCol(file, directiveLine, 1), directive + "\n"));
+    }
+}
+
+// constants of enums and global variables used by an expression (e.g. the initializer of a variable)
+class ASTVisitorDataUses: public RecursiveASTVisitor<ASTVisitorDataUses>
+{
+public:
+    std::set<std::string> uses;
+
+    bool VisitDeclRefExpr(DeclRefExpr *Expression)
+    {
+        ValueDecl *declaration = Expression->getDecl();
+
+        if (isa<EnumConstantDecl>(declaration) || (isa<VarDecl>(declaration) && cast<VarDecl>(declaration)->isFileVarDecl()))
+        {
+            this->uses.insert(declaration->getNameAsString());
+        }
+
+        return true;
+    }
+};
+
+// names of the constants of an enum, along with the constants and variables their values use
+PRIVATE void getEnumConstants(EnumDecl *Declaration, std::set<std::string> &names, std::set<std::string> &uses)
+{
+    ASTVisitorDataUses visitor;
+
+    for (auto it = Declaration->enumerator_begin(); it != Declaration->enumerator_end(); ++it)
+    {
+        names.insert((*it)->getNameAsString());
+
+        if ((*it)->getInitExpr() != NULL)
+        {
+            visitor.TraverseStmt((*it)->getInitExpr());
+        }
+    }
+
+    uses.insert(visitor.uses.begin(), visitor.uses.end());
+}
+
+// appends the given index after the indices it depends on (depth-first)
+PRIVATE void appendInDependencyOrder(unsigned idx, const std::vector<std::vector<unsigned>> &dependencies, std::vector<bool> &visited, std::vector<unsigned> &order)
+{
+    if (visited[idx])
+    {
+        return;
+    }
+
+    visited[idx] = true;
+
+    for (auto it = dependencies[idx].begin(); it != dependencies[idx].end(); ++it)
+    {
+        appendInDependencyOrder(*it, dependencies, visited, order);
+    }
+
+    order.push_back(idx);
+}
+
+// writes a file for each kernel containing the data, records and functions the kernel requires, in the order of the
+// translation unit, interleaved with the preprocessor directives of the translated file and its headers (without #include)
+void PassTransformation::writeAmalgamatedKernels()
+{
+    SourceManager &sourceManager = this->context->getSourceManager();
+
+    // functions defined in this file (the others are looked up in the files translated before)
+    std::set<std::string> definedFunctions;
+
+    // the functions generated for this file may be required by kernels of files translated later,
+    // which only see their prototypes (if inserted into a header)
+    for (auto it = this->pendingCode.begin(); it != this->pendingCode.end(); ++it)
+    {
+        if (it->Kind == CODE_PROTOTYPE)
+        {
+            this->results.addGeneratedFunction(it->Owner);
+        }
+        else if (it->Kind == CODE_DEFINITION)
+        {
+            GeneratedDefinition definition;
+            definition.Code = it->Code;
+            definition.References = this->references[it->Owner];
+
+            this->results.addGeneratedDefinition(it->Owner, definition);
+
+            definedFunctions.insert(it->Owner);
+        }
+    }
+
+    // code kept in place (data and functions, only if used by the kernel)
+    std::vector<PendingCode> code;
+
+    TranslationUnitDecl *translationUnit = this->context->getTranslationUnitDecl();
+    for (auto it = translationUnit->decls_begin(); it != translationUnit->decls_end(); ++it)
+    {
+        Decl *declaration = *it;
+
+        if (declaration->isImplicit() || isInSystemFile(declaration))
+        {
+            continue;
+        }
+
+        PendingCode item;
+        item.Location = sourceManager.getExpansionLoc(declaration->getLocStart());
+        item.End = sourceManager.getExpansionLoc(declaration->getLocEnd());
+
+        std::string source = this->rewriter->getRewrittenText(SourceRange(item.Location, item.End));
+        if (source.empty())
+        {
+            continue;
+        }
+
+        if (isa<FunctionDecl>(declaration))
+        {
+            FunctionDecl *function = cast<FunctionDecl>(declaration);
+
+            // methods and specializations are generated
+            if (isa<CXXMethodDecl>(function) || function->getTemplatedKind() != FunctionDecl::TemplatedKind::TK_NonTemplate)
+            {
+                continue;
+            }
+
+            item.Kind = CODE_FUNCTION;
+            item.Owner = this->getEmittedName(function);
+            item.Code = source + (function->isThisDeclarationADefinition() ? "\n\n" : ";\n");
+
+            if (function->isThisDeclarationADefinition())
+            {
+                definedFunctions.insert(item.Owner);
+            }
+        }
+        else if (isa<TagDecl>(declaration))
+        {
+            TagDecl *tag = cast<TagDecl>(declaration);
+
+            // records/enums embedded in a typedef/variable are part of its declaration,
+            // records with methods and specializations are flattened
+            if (tag->isEmbeddedInDeclarator() ||
+                (isa<CXXRecordDecl>(tag) && (tag->getName().empty() || isa<ClassTemplateSpecializationDecl>(tag) || this->containsMethods(cast<CXXRecordDecl>(tag)))))
+            {
+                continue;
+            }
+
+            item.Kind = CODE_DATA;
+            item.Owner = tag->getNameAsString();
+            item.Code = source + ";\n";
+
+            // NOTE: the constants of anonymous enums are their only names
+            if (!item.Owner.empty())
+            {
+                item.Names.insert(item.Owner);
+            }
+
+            if (isa<EnumDecl>(tag))
+            {
+                getEnumConstants(cast<EnumDecl>(tag), item.Names, item.Uses);
+            }
+            else if (isa<RecordDecl>(tag) && tag->isCompleteDefinition())
+            {
+                RecordDecl *record = cast<RecordDecl>(tag);
+
+                for (auto itField = record->field_begin(); itField != record->field_end(); ++itField)
+                {
+                    this->getValueDependencies(itField->getType(), item.Dependencies);
+                    this->getTypeUses(itField->getType(), item.Uses);
+                }
+
+                // the typedef has been inserted after the declaration (see TraverseCXXRecordDecl())
+                if (!this->hasAlreadyATypeDef(item.Owner))
+                {
+                    item.Code += "typedef " + tag->getKindName().str() + " " + item.Owner + " " + item.Owner + ";\n";
+                }
+            }
+        }
+        else if (isa<TypedefNameDecl>(declaration) || isa<VarDecl>(declaration))
+        {
+            QualType type = isa<VarDecl>(declaration) ? cast<VarDecl>(declaration)->getType() : cast<TypedefNameDecl>(declaration)->getUnderlyingType();
+
+            item.Kind = CODE_DATA;
+            item.Owner = cast<NamedDecl>(declaration)->getNameAsString();
+            item.Code = source + ";\n";
+            item.Names.insert(item.Owner);
+
+            this->getValueDependencies(type, item.Dependencies);
+            this->getTypeUses(type, item.Uses);
+
+            // a record/enum declared along with the typedef/variable (e.g. 'typedef enum { A, B } E;')
+            const TagType *tagType = this->context->getBaseElementType(type)->getAs<TagType>();
+            if (tagType != NULL && tagType->getDecl()->isEmbeddedInDeclarator())
+            {
+                TagDecl *tag = tagType->getDecl();
+
+                if (!tag->getName().empty())
+                {
+                    item.Names.insert(tag->getNameAsString());
+                }
+
+                if (isa<EnumDecl>(tag))
+                {
+                    getEnumConstants(cast<EnumDecl>(tag), item.Names, item.Uses);
+                }
+                else if (isa<RecordDecl>(tag) && tag->isCompleteDefinition())
+                {
+                    for (auto itField = cast<RecordDecl>(tag)->field_begin(); itField != cast<RecordDecl>(tag)->field_end(); ++itField)
+                    {
+                        this->getTypeUses(itField->getType(), item.Uses);
+                    }
+                }
+            }
+
+            if (isa<VarDecl>(declaration) && cast<VarDecl>(declaration)->getInit() != NULL)
+            {
+                ASTVisitorDataUses visitor;
+                visitor.TraverseStmt(cast<VarDecl>(declaration)->getInit());
+
+                item.Uses.insert(visitor.uses.begin(), visitor.uses.end());
+            }
+        }
+        else
+        {
+            // templates are generated, other declarations (e.g. namespaces) are not supported
+            continue;
+        }
+
+        code.push_back(item);
+    }
+
+    code.insert(code.end(), this->pendingCode.begin(), this->pendingCode.end());
+
+    // the code is emitted in the order of the translation unit (i.e. where it would have been inserted into the
+    // translated file), generated code before the declaration it has been inserted at, in the order it has been emitted
+    std::stable_sort(code.begin(), code.end(), [&sourceManager](const PendingCode &a, const PendingCode &b)
+    {
+        if (a.Location.isInvalid() || b.Location.isInvalid())
+        {
+            return a.Location.isValid() && b.Location.isInvalid();
+        }
+
+        if (a.Location == b.Location)
+        {
+            return a.End.isInvalid() && b.End.isValid();
+        }
+
+        return sourceManager.isBeforeInTranslationUnit(a.Location, b.Location);
+    });
+
+    // a record has to be complete before another one contains it by value
+    // (e.g. a specialization used by a template declared earlier)
+    std::vector<unsigned> order;
+    {
+        std::map<std::string, std::vector<unsigned>> indicesOfOwner;
+        for (unsigned idx = 0; idx < code.size(); ++idx)
+        {
+            if (code[idx].Kind == CODE_DATA || code[idx].Kind == CODE_RECORD)
+            {
+                indicesOfOwner[code[idx].Owner].push_back(idx);
+            }
+        }
+
+        std::vector<std::vector<unsigned>> dependencies(code.size());
+        for (unsigned idx = 0; idx < code.size(); ++idx)
+        {
+            for (auto it = code[idx].Dependencies.begin(); it != code[idx].Dependencies.end(); ++it)
+            {
+                auto itIndices = indicesOfOwner.find(*it);
+                if (itIndices != indicesOfOwner.end())
+                {
+                    dependencies[idx].insert(dependencies[idx].end(), itIndices->second.begin(), itIndices->second.end());
+                }
+            }
+        }
+
+        std::vector<bool> visited(code.size(), false);
+        for (unsigned idx = 0; idx < code.size(); ++idx)
+        {
+            appendInDependencyOrder(idx, dependencies, visited, order);
+        }
+    }
+
+    // the declarations of data by the names they declare
+    std::map<std::string, std::vector<unsigned>> dataOfName;
+    for (unsigned idx = 0; idx < code.size(); ++idx)
+    {
+        if (code[idx].Kind == CODE_DATA)
+        {
+            for (auto it = code[idx].Names.begin(); it != code[idx].Names.end(); ++it)
+            {
+                dataOfName[*it].push_back(idx);
+            }
+        }
+    }
+
+    // preprocessor directives of the file and its headers (in the order of inclusion)
+    std::vector<std::pair<SourceLocation, std::string>> directives;
+    {
+        std::map<std::pair<FileID, unsigned>, std::vector<FileID>> includes;
+        for (unsigned idx = 0; idx < sourceManager.local_sloc_entry_size(); ++idx)
+        {
+            const SrcMgr::SLocEntry &entry = sourceManager.getLocalSLocEntry(idx);
+            if (!entry.isFile() || entry.getFile().getIncludeLoc().isInvalid() || entry.getFile().getFileCharacteristic() != SrcMgr::C_User)
+            {
+                continue;
+            }
+
+            FileID file = sourceManager.getFileID(SourceLocation::getFromRawEncoding(entry.getOffset()));
+            if (sourceManager.getFileEntryForID(file) == NULL)
+            {
+                continue;
+            }
+
+            SourceLocation includeLocation = entry.getFile().getIncludeLoc();
+            includes[std::make_pair(sourceManager.getFileID(includeLocation), sourceManager.getSpellingLineNumber(includeLocation))].push_back(file);
+        }
+
+        std::set<const FileEntry *> visitedFiles;
+        appendDirectives(sourceManager, sourceManager.getMainFileID(), includes, visitedFiles, directives);
+    }
+
+    // directives inside a declaration kept in place (e.g. in the body of a function) are part of its code
+    std::vector<int> directiveContainers(directives.size(), -1);
+    {
+        unsigned idx = 0;
+        for (unsigned directiveIdx = 0; directiveIdx < directives.size(); ++directiveIdx)
+        {
+            const SourceLocation &location = directives[directiveIdx].first;
+
+            while (idx < code.size() && (code[idx].End.isInvalid() || sourceManager.isBeforeInTranslationUnit(code[idx].End, location)))
+            {
+                ++idx;
+            }
+
+            if (idx < code.size() && sourceManager.isBeforeInTranslationUnit(code[idx].Location, location))
+            {
+                directiveContainers[directiveIdx] = idx;
+            }
+        }
+    }
+
+    for (auto itKernel = this->kernelFunctions.begin(); itKernel != this->kernelFunctions.end(); ++itKernel)
+    {
+        std::vector<std::string> roots(1, *itKernel);
+
+        // definitions generated for other files are added along with the functions/records they reference,
+        // declarations of data along with the typedefs, enums, records and variables they use
+        std::set<std::string> reachable;
+        std::set<unsigned> requiredData;
+        std::vector<const GeneratedDefinition *> importedDefinitions;
+        std::set<std::string> imported;
+        while (!roots.empty())
+        {
+            this->getReachable(roots, reachable);
+            roots.clear();
+
+            for (auto it = reachable.begin(); it != reachable.end(); ++it)
+            {
+                auto itData = dataOfName.find(*it);
+                if (itData != dataOfName.end())
+                {
+                    for (auto itIdx = itData->second.begin(); itIdx != itData->second.end(); ++itIdx)
+                    {
+                        if (requiredData.insert(*itIdx).second)
+                        {
+                            roots.insert(roots.end(), code[*itIdx].Uses.begin(), code[*itIdx].Uses.end());
+                            roots.insert(roots.end(), code[*itIdx].Dependencies.begin(), code[*itIdx].Dependencies.end());
+                        }
+                    }
+                }
+
+                if (definedFunctions.find(*it) != definedFunctions.end() || imported.find(*it) != imported.end())
+                {
+                    continue;
+                }
+
+                const GeneratedDefinition *definition = this->results.getGeneratedDefinition(*it);
+                if (definition != NULL)
+                {
+                    imported.insert(*it);
+                    importedDefinitions.push_back(definition);
+                    roots.insert(roots.end(), definition->References.begin(), definition->References.end());
+                }
+                else if (this->results.isGeneratedFunction(*it))
+                {
+                    FAIL("unable to amalgamate kernel " << *itKernel << ": no definition of the generated function " << *it);
+                }
+            }
+        }
+
+        std::vector<bool> emitted(code.size(), false);
+        for (unsigned idx = 0; idx < code.size(); ++idx)
+        {
+            emitted[idx] = (code[idx].Kind == CODE_DATA) ? (requiredData.find(idx) != requiredData.end()) : (reachable.find(code[idx].Owner) != reachable.end());
+        }
+
+        std::stringstream strAmalgamation;
+        strAmalgamation << "// kernel " << *itKernel << " of " << this->FileName << " (amalgamated by patos)\n\n";
+        strAmalgamation << getMacroDirectives(this->macros);
+
+        // every piece of code is preceded by the directives preceding it in the translation unit, so that
+        // (re)definitions of macros and conditionals apply to the same code as in the translated file
+        unsigned directiveIdx = 0;
+        for (auto it = order.begin(); it != order.end(); ++it)
+        {
+            if (!emitted[*it])
+            {
+                continue;
+            }
+
+            for (; directiveIdx < directives.size() && code[*it].Location.isValid() &&
+                   sourceManager.isBeforeInTranslationUnit(directives[directiveIdx].first, code[*it].Location); ++directiveIdx)
+            {
+                if (directiveContainers[directiveIdx] < 0 || !emitted[directiveContainers[directiveIdx]])
+                {
+                    strAmalgamation << directives[directiveIdx].second;
+                }
+            }
+
+            strAmalgamation << code[*it].Code;
+        }
+
+        for (; directiveIdx < directives.size(); ++directiveIdx)
+        {
+            if (directiveContainers[directiveIdx] < 0 || !emitted[directiveContainers[directiveIdx]])
+            {
+                strAmalgamation << directives[directiveIdx].second;
+            }
+        }
+
+        for (auto it = importedDefinitions.begin(); it != importedDefinitions.end(); ++it)
+        {
+            strAmalgamation << (*it)->Code;
+        }
+
+        std::string fileName = getAbsolutePath(concatPaths(this->arguments.AmalgamateDirectory, this->FileName), *itKernel, SUFFIX_AMALGAMATION);
+
+        if (!makeDirectories(stripFileName(fileName)) || !writeFile(fileName, strAmalgamation.str()))
+        {
+            FAIL("unable to write amalgamated kernel to " << fileName);
         }
-    }
 
-    return Declaration->getNameInfo().getSourceRange();
+        DBG << "amalgamated kernel " << *itKernel << " written to " << fileName << std::endl;
+    }
 }
 
-class ASTVisitorTemporaryObject: public RecursiveASTVisitor<ASTVisitorTemporaryObject>
+void PassTransformation::addGeneratedCode(const std::string &owner, unsigned long bytes)
 {
-private:
-    bool foundTemporaryObject;
-    std::vector<Expr *> *result;
+    this->generatedBytes[owner] += bytes;
+}
 
-public:
-    bool usesTemporaryObject(Stmt *Statement, std::vector<Expr *> &result)
-    {
-        this->foundTemporaryObject = false;
-        this->result = &result;
+void PassTransformation::registerSpecialization(const std::string &templateName, bool isClassTemplate, const std::string &mangledName)
+{
+    SpecializationInfo &specialization = this->emittedSpecializations[mangledName];
 
-        this->TraverseStmt(Statement);
+    specialization.TemplateName = templateName;
+    specialization.IsClassTemplate = isClassTemplate;
+    specialization.MangledName = mangledName;
+    specialization.FileName = this->FileName;
+    specialization.GeneratedBytes = 0;
+}
 
-        return this->foundTemporaryObject;
-    }
+void PassTransformation::recordResults()
+{
+    // breadth-first search starting at the kernels to find the first chain
+    // of references leading to each function/record
+    std::map<std::string, std::string> kernelOf;
+    std::map<std::string, std::string> predecessor;
+    std::vector<std::string> queue;
 
-    bool TraverseCompoundStmt(CompoundStmt *Statement)
+    for (auto it = this->kernelFunctions.begin(); it != this->kernelFunctions.end(); ++it)
     {
-        // NOTE: we do not want to find temporary objects in nested compound statements
-        // -> do not traverse compound statement
-
-        return true;
+        kernelOf[*it] = *it;
+        queue.push_back(*it);
     }
 
-    bool VisitCXXFunctionalCastExpr(CXXFunctionalCastExpr *Expression)
+    for (unsigned int idx = 0; idx < queue.size(); ++idx)
     {
-        this->foundTemporaryObject = true;
-        this->result->push_back(Expression);
-
-        return true;
-    }
+        const std::string current = queue[idx];
 
-    bool VisitCXXTemporaryObjectExpr(CXXTemporaryObjectExpr *Expression)
-    {
-        this->foundTemporaryObject = true;
-        this->result->push_back(Expression);
+        auto itReferences = this->references.find(current);
+        if (itReferences == this->references.end())
+        {
+            continue;
+        }
 
-        return true;
+        for (auto it = itReferences->second.begin(); it != itReferences->second.end(); ++it)
+        {
+            if (kernelOf.find(*it) == kernelOf.end())
+            {
+                kernelOf[*it] = kernelOf[current];
+                predecessor[*it] = current;
+                queue.push_back(*it);
+            }
+        }
     }
-};
-
-bool PassTransformation::findUsagesOfTemporaryObjects(Stmt *Statement, std::vector<Expr *> &result)
-{
-    // sooo meta!
-    return ASTVisitorTemporaryObject().usesTemporaryObject(Statement, result);
-}
 
-std::string PassTransformation::getNameForTemporaryObject(Expr *Expression)
-{
-    if (this->temporaryObjectNames.find(Expression) != this->temporaryObjectNames.end())
+    for (auto it = this->emittedSpecializations.begin(); it != this->emittedSpecializations.end(); ++it)
     {
-        return this->temporaryObjectNames[Expression];
-    }
+        SpecializationInfo &specialization = it->second;
 
-    std::string temporaryName = "__patos_temporary_" + std::to_string(this->temporaryObjectCounter++);
-    this->temporaryObjectNames[Expression] = temporaryName;
+        specialization.GeneratedBytes = this->generatedBytes[specialization.MangledName];
 
-    return temporaryName;
-}
+        auto itKernel = kernelOf.find(specialization.MangledName);
+        if (itKernel != kernelOf.end())
+        {
+            specialization.Kernel = itKernel->second;
 
-bool PassTransformation::hasAlreadyATypeDef(const std::string &recordName)
-{
-    TranslationUnitDecl *translationUnit = this->context->getTranslationUnitDecl();
+            for (std::string name = specialization.MangledName; ; name = predecessor[name])
+            {
+                specialization.CallChain.insert(specialization.CallChain.begin(), name);
 
-    for (auto it = translationUnit->decls_begin(); it != translationUnit->decls_end(); ++it)
-    {
-        Decl *declaration = *it;
+                if (name == specialization.Kernel)
+                {
+                    break;
+                }
+            }
+        }
 
-        if (isa<TypedefDecl>(declaration) && cast<TypedefDecl>(declaration)->getNameAsString() == recordName)
-            return true;
+        this->results.addSpecialization(specialization);
     }
-
-    return false;
 }
 
 
@@ -452,7 +2941,7 @@ bool PassTransformation::hasAlreadyATypeDef(const std::string &recordName)
 // =============================================== //
 
 
-void PassTransformation::HandleTranslationUnit(clang::ASTContext &context)
+void PassTransformation::processTranslationUnit(clang::ASTContext &context)
 {
     DBG << "Consume [TRANSFORMATION]: " << this->FileName << std::endl;
 
@@ -463,10 +2952,40 @@ void PassTransformation::HandleTranslationUnit(clang::ASTContext &context)
 
     this->currentRewriter = this->rewriter;
     this->context = &context;
+
+    if (this->arguments.OptimizeLayout || this->arguments.WriteLayoutReport)
+    {
+        this->findRecordsWithFixedLayout(context.getTranslationUnitDecl());
+    }
+
+    if (this->arguments.InlineThreshold > 0)
+    {
+        this->findFunctionsCalledInsideLoops(context.getTranslationUnitDecl());
+    }
+
     this->TraverseDecl(context.getTranslationUnitDecl());
 
+    // emit the address space clones requested while transforming the functions
+    // (which may request further clones)
+    for (unsigned int idx = 0; idx < this->cloneWorklist.size(); ++idx)
+    {
+        this->emitAddressSpaceClone(this->requestedClones[this->cloneWorklist[idx]]);
+    }
+
+    if (this->arguments.Amalgamate)
+    {
+        this->writeAmalgamatedKernels();
+    }
+
+    if (this->arguments.PruneUnreachable || this->arguments.Amalgamate)
+    {
+        this->emitPendingCode();
+    }
+
     // write result to disk
     this->writeChangesToDisk();
+
+    this->recordResults();
 }
 
 bool PassTransformation::TraverseClassTemplateDecl(ClassTemplateDecl *Declaration)
@@ -479,33 +2998,39 @@ bool PassTransformation::TraverseClassTemplateDecl(ClassTemplateDecl *Declaratio
 
     DBG << "found class template declaration: " << Declaration->getNameAsString() << std::endl;
 
+    std::vector<ClassTemplateSpecializationDecl *> specializations;
+    this->getSpecializations(Declaration, specializations);
+
     // iterate over all specializations
-    for (auto it = Declaration->spec_begin(); it != Declaration->spec_end(); ++it)
+    for (auto it = specializations.begin(); it != specializations.end(); ++it)
     {
         ClassTemplateSpecializationDecl *specializationDeclaration = *it;
 
-        #ifdef DEBUG_MODE
+        if (PatosLog::isEnabled(PatosLog::LEVEL_DEBUG))
         {
             DBG << "   found specialization: ";
 
             const TemplateArgumentList &templateArguments = specializationDeclaration->getTemplateArgs();
             for (unsigned idx = 0; idx < templateArguments.size(); ++idx)
             {
-                const TemplateArgument &templateArgument = templateArguments.get(idx);
-                QualType argumentType = templateArgument.getAsType();
+                // NOTE: arguments may be types or values
+                std::string argumentString;
+                llvm::raw_string_ostream argumentStream(argumentString);
+                templateArguments.get(idx).print(this->context->getPrintingPolicy(), argumentStream);
 
-                std::cout << argumentType.getAsString();
+                PatosLog::sink() << argumentStream.str();
                 if (idx < templateArguments.size()-1)
-                    std::cout << ", ";
+                    PatosLog::sink() << ", ";
             }
-            std::cout << std::endl;
+            PatosLog::sink() << std::endl;
         }
-        #endif
 
         // check if we already have an according specialization
         std::string mangledName = PatosNameMangling::getMangledNameForRecord(specializationDeclaration);
         if (!this->hasAlreadyADeclaration(mangledName))
         {
+            this->registerSpecialization(Declaration->getQualifiedNameAsString(), true, mangledName);
+
             // save old state
             Rewriter *oldRewriter = this->currentRewriter;
 
@@ -563,6 +3088,19 @@ bool PassTransformation::TraverseCXXRecordDecl(CXXRecordDecl *Declaration)
             this->currentRewriter->InsertTextAfter(locationEnd, "\ntypedef struct " + recordName + " " + recordName + ";\n");
         }
 
+        // the struct of arrays and value type markers are not OpenCL keywords
+        for (auto it = Declaration->attr_begin(); it != Declaration->attr_end(); ++it)
+        {
+            if (isa<AnnotateAttr>(*it) && (cast<AnnotateAttr>(*it)->getAnnotation().str() == PATOS_SOA_ANNOTATION ||
+                                           cast<AnnotateAttr>(*it)->getAnnotation().str() == PATOS_VALUE_TYPE_ANNOTATION))
+            {
+                SourceManager &sourceManager = this->context->getSourceManager();
+                SourceLocation locationMarker = sourceManager.getExpansionLoc((*it)->getLocation());
+
+                this->currentRewriter->RemoveText(locationMarker, Lexer::MeasureTokenLength(locationMarker, sourceManager, this->context->getLangOpts()));
+            }
+        }
+
         return true;
     }
 
@@ -575,9 +3113,11 @@ bool PassTransformation::TraverseCXXRecordDecl(CXXRecordDecl *Declaration)
     {
         std::string flatVersion = this->createFlatVersionOfRecord(Declaration);
 
-        this->rewriter->InsertTextAfter(insertLocation, flatVersion);
+        this->emitCode(insertLocation, flatVersion, this->getOutputName(Declaration), CODE_RECORD, Declaration);
+
+        this->addGeneratedCode(this->getOutputName(Declaration), flatVersion.size());
 
-        #ifdef DEBUG_MODE
+        if (PatosLog::isEnabled(PatosLog::LEVEL_DEBUG))
         {
             std::string mangledName;
             if (isa<ClassTemplateSpecializationDecl>(Declaration))
@@ -591,7 +3131,6 @@ bool PassTransformation::TraverseCXXRecordDecl(CXXRecordDecl *Declaration)
 
             DBG << "created flattened version for " << mangledName << std::endl;
         }
-        #endif
     }
 
     // iterate over all methods contained in this record
@@ -621,14 +3160,32 @@ bool PassTransformation::TraverseCXXRecordDecl(CXXRecordDecl *Declaration)
             CXXDestructorDecl *destructorDeclaration = cast<CXXDestructorDecl>(methodDeclaration);
             if (!destructorDeclaration->isImplicit())
             {
-                ERROR << "explicit destructors not supported by patos" << std::endl;
-                exit(EXIT_FAILURE);
+                FAIL("explicit destructors not supported by patos");
             }
             continue; // do not transform destructor
         }
 
         // transform method and add to source
         this->transformFunction(methodDeclaration, insertLocation, methodDeclaration->isThisDeclarationADefinition());
+
+        // constructors of large records get an additional variant initializing a given instance
+        if (isa<CXXConstructorDecl>(methodDeclaration) && this->constructsInPlace(cast<CXXConstructorDecl>(methodDeclaration)))
+        {
+            // save old state
+            Rewriter *oldRewriter = this->currentRewriter;
+
+            // create a new rewriter for the in-place variant
+            Rewriter inPlaceRewriter;
+            inPlaceRewriter.setSourceMgr(this->context->getSourceManager(), this->context->getLangOpts());
+            this->currentRewriter = &inPlaceRewriter;
+
+            this->currentConstructorInPlace = true;
+            this->transformFunction(methodDeclaration, insertLocation, methodDeclaration->isThisDeclarationADefinition());
+            this->currentConstructorInPlace = false;
+
+            // restore old state
+            this->currentRewriter = oldRewriter;
+        }
     }
 
     // save old state
@@ -643,17 +3200,22 @@ bool PassTransformation::TraverseCXXRecordDecl(CXXRecordDecl *Declaration)
         {
             FunctionTemplateDecl *functionTemplateDeclaration = cast<FunctionTemplateDecl>(declaration);
 
+            std::vector<FunctionDecl *> specializations;
+            this->getSpecializations(functionTemplateDeclaration, specializations);
+
             // iterate over all specializations
-            for (auto itSpec = functionTemplateDeclaration->spec_begin(); itSpec != functionTemplateDeclaration->spec_end(); ++itSpec)
+            for (auto itSpec = specializations.begin(); itSpec != specializations.end(); ++itSpec)
             {
                 FunctionDecl *functionTemplateSpecialization = *itSpec;
 
                 if (!isa<CXXMethodDecl>(functionTemplateSpecialization))
                 {
-                    ERROR << "specialization of template method is not a method" << std::endl;
-                    exit(EXIT_FAILURE);
+                    FAIL("specialization of template method is not a method");
                 }
 
+                this->registerSpecialization(functionTemplateDeclaration->getQualifiedNameAsString(), false,
+                                             PatosNameMangling::getMangledNameForFunction(functionTemplateSpecialization));
+
                 // create a new rewriter for the current specialization
                 Rewriter specializationRewriter;
                 specializationRewriter.setSourceMgr(this->context->getSourceManager(), this->context->getLangOpts());
@@ -701,7 +3263,44 @@ bool PassTransformation::TraverseCXXMethodDecl(CXXMethodDecl *Declaration)
         return true;
     }
 
+    std::string oldOwner = this->currentOwner;
+    bool oldInstanceByValue = this->currentInstanceByValue;
+    bool oldWithoutInstance = this->currentWithoutInstance;
     RecursiveASTVisitor::TraverseCXXMethodDecl(Declaration);
+    this->currentOwner = oldOwner;
+    this->currentInstanceByValue = oldInstanceByValue;
+    this->currentWithoutInstance = oldWithoutInstance;
+
+    return true;
+}
+
+bool PassTransformation::TraverseFunctionDecl(FunctionDecl *Declaration)
+{
+    std::string oldOwner = this->currentOwner;
+    RecursiveASTVisitor::TraverseFunctionDecl(Declaration);
+    this->currentOwner = oldOwner;
+
+    // split parameters passed as struct of arrays (see VisitFunctionDecl())
+    // NOTE: this has to be done after the traversal, since the types of the parameters are transformed, too
+    for (unsigned idx = 0; idx < Declaration->getNumParams(); ++idx)
+    {
+        ParmVarDecl *parameter = Declaration->getParamDecl(idx);
+
+        auto it = this->structOfArraysParameters.find(parameter);
+        if (it == this->structOfArraysParameters.end())
+        {
+            continue;
+        }
+
+        // the parameter may begin with an address space (i.e. a macro)
+        SourceManager &sourceManager = this->context->getSourceManager();
+        SourceRange parameterRange(sourceManager.getExpansionLoc(parameter->getLocStart()), sourceManager.getExpansionLoc(parameter->getLocEnd()));
+
+        std::string parameters = this->getStructOfArraysParameters(this->getStructOfArraysPointee(parameter->getType()), parameter->getNameAsString(),
+                                                                   it->second, parameter->getType()->getPointeeType().isConstQualified());
+
+        this->currentRewriter->ReplaceText(parameterRange, parameters);
+    }
 
     return true;
 }
@@ -728,15 +3327,51 @@ bool PassTransformation::VisitCXXMethodDecl(CXXMethodDecl *Declaration)
         parentName = Declaration->getParent()->getNameAsString();
     }
 
+    // a method requires its record
+    this->addReference(parentName);
+
+    this->currentWithoutInstance = !this->needsInstance(Declaration);
+
     // add additional parameter (thisRef)
-    if (!isa<CXXConstructorDecl>(Declaration))
+    // NOTE: the in-place variant of a constructor gets the instance like any other method
+    if (this->currentWithoutInstance)
+    {
+        // method of an empty record -> no additional parameter
+        this->currentInstanceByValue = false;
+    }
+    else if (!isa<CXXConstructorDecl>(Declaration) || this->currentConstructorInPlace)
     {
         // find location of left parenthesis (took me alsmost an hour to get there...)
         SourceLocation locationEndOfDeclarator = Declaration->getNameInfo().getLocEnd();
         SourceLocation locationLParen = Lexer::findLocationAfterToken(locationEndOfDeclarator, tok::l_paren, sourceManager, languageOptions, true);
 
         // build string for additional parameter
-        std::string additionalParameter = "struct " + parentName + " *thisRef";
+        bool isStructOfArraysClone = (this->currentClone != NULL && this->currentClone->StructOfArraysRecord != NULL);
+        this->currentInstanceByValue = !isStructOfArraysClone && this->passesInstanceByValue(Declaration);
+
+        std::string additionalParameter;
+        if (isStructOfArraysClone)
+        {
+            // instance is an element of a struct of arrays -> arrays and index
+            additionalParameter = this->getStructOfArraysParameters(this->currentClone->StructOfArraysRecord, "thisRef",
+                                                                    this->currentClone->StructOfArraysAddressSpace, Declaration->isConst())
+                                  + ", size_t thisIdx";
+        }
+        else if (this->currentInstanceByValue)
+        {
+            additionalParameter = "struct " + parentName + " thisVal";
+        }
+        else
+        {
+            additionalParameter = "struct " + parentName + " *thisRef";
+
+            // in a clone, the instance lives in the address space it has been called upon
+            if (this->currentClone != NULL && !this->currentClone->ThisAddressSpace.empty() &&
+                this->currentClone->ThisAddressSpace != PATOS_PRIVATE_ADDRESS_SPACE)
+            {
+                additionalParameter = this->currentClone->ThisAddressSpace + " " + additionalParameter;
+            }
+        }
 
         // add additional parameter to list of parameters
         if (Declaration->getNumParams() == 0)
@@ -756,6 +3391,8 @@ bool PassTransformation::VisitCXXMethodDecl(CXXMethodDecl *Declaration)
     }
     else
     {
+        this->currentInstanceByValue = false;
+
         // method is a constructor
         // -> add additional local variable(s) and return expression
         Stmt *body = Declaration->getBody();
@@ -763,8 +3400,7 @@ bool PassTransformation::VisitCXXMethodDecl(CXXMethodDecl *Declaration)
         {
             if (!isa<CompoundStmt>(body))
             {
-                ERROR << "body of constructor is not a compound statement" << std::endl;
-                exit(EXIT_FAILURE);
+                FAIL("body of constructor is not a compound statement");
             }
 
             CompoundStmt *compoundBody = cast<CompoundStmt>(body);
@@ -797,16 +3433,28 @@ bool PassTransformation::TraverseFunctionTemplateDecl(FunctionTemplateDecl *Decl
         return true;
     }
 
+    std::vector<FunctionDecl *> specializations;
+    this->getSpecializations(Declaration, specializations);
+
     // iterate over all specializations
-    for (auto it = Declaration->spec_begin(); it != Declaration->spec_end(); ++it)
+    for (auto it = specializations.begin(); it != specializations.end(); ++it)
     {
         FunctionDecl *declarationSpecialization = *it;
 
         // check if we only have an according specialization
         std::string mangledName = PatosNameMangling::getMangledNameForFunction(declarationSpecialization);
+
+        // remember the names of explicitly instantiated kernels, since the template arguments
+        // given by the user may be spelled differently (e.g. using typedefs)
+        if (declarationSpecialization->getTemplateSpecializationKind() == TSK_ExplicitInstantiationDefinition &&
+            this->isKernelFunction(declarationSpecialization))
+        {
+            this->results.addExplicitInstantiation(this->getSourceLine(declarationSpecialization->getPointOfInstantiation()), mangledName);
+        }
         if (!this->hasAlreadyADeclaration(mangledName))
         {
             // 'new' specialization -> transformation needed
+            this->registerSpecialization(Declaration->getQualifiedNameAsString(), false, mangledName);
 
             // save old state
             Rewriter *oldRewriter = this->currentRewriter;
@@ -844,16 +3492,44 @@ bool PassTransformation::VisitFunctionDecl(FunctionDecl *Declaration)
     DBG << "         @" << Declaration->getLocStart().printToString(this->context->getSourceManager()) << std::endl;
     DBG << "         templated kind: " << Declaration->getTemplatedKind() << std::endl;
 
+    // everything referenced from here on is required by this function
+    this->currentOwner = this->getEmittedName(Declaration);
+
+    if (this->isKernelFunction(Declaration))
+    {
+        this->kernelFunctions.insert(this->currentOwner);
+
+        // pointers to records annotated with '__soa' are passed as one array per field
+        for (unsigned idx = 0; idx < Declaration->getNumParams(); ++idx)
+        {
+            ParmVarDecl *parameter = Declaration->getParamDecl(idx);
+
+            if (this->getStructOfArraysPointee(parameter->getType()) != NULL)
+            {
+                std::string addressSpace = this->getAnnotatedAddressSpace(parameter);
+                this->structOfArraysParameters[parameter] = addressSpace.empty() ? "__global" : addressSpace;
+            }
+        }
+    }
+
+    // number temporary objects per function, so that the names do not depend on
+    // the functions that have been transformed before
+    if (this->arguments.Reproducible && Declaration->doesThisDeclarationHaveABody())
+    {
+        this->temporaryObjectCounter = 0;
+    }
+
     // check if we have to perform name mangling for this function declaration
-    // this is the case if it is a specialization of a template function or if it is a method of a record
+    // this is the case if it is a specialization of a template function, if it is a method of a record
+    // or if it is an address space clone
     FunctionDecl::TemplatedKind kind = Declaration->getTemplatedKind();
     if (kind == FunctionDecl::TemplatedKind::TK_FunctionTemplateSpecialization ||
-        isa<CXXMethodDecl>(Declaration))
+        isa<CXXMethodDecl>(Declaration) || this->currentClone != NULL)
     {
         DBG << "         perform name mangling (" << kind << ")" << std::endl;
 
         // get mangled name for current specialization
-        std::string mangledName = PatosNameMangling::getMangledNameForFunction(Declaration);
+        std::string mangledName = this->getEmittedName(Declaration);
 
         DBG << "         mangled name: " << mangledName << std::endl;
 
@@ -876,6 +3552,20 @@ bool PassTransformation::TraverseTypeLoc(TypeLoc typeLoc)
     if (recordType != NULL)
     {
         isTemplateSpecialization = isa<ClassTemplateSpecializationDecl>(recordType->getDecl());
+
+        this->addReference(this->getOutputName(recordType->getDecl()));
+    }
+
+    // typedefs and enums are required by amalgamated kernels using them
+    if (isa<TypedefType>(type) || isa<EnumType>(type) || isa<SubstTemplateTypeParmType>(type))
+    {
+        std::set<std::string> uses;
+        this->getTypeUses(typeLoc.getType(), uses);
+
+        for (auto it = uses.begin(); it != uses.end(); ++it)
+        {
+            this->addReference(*it);
+        }
     }
 
     // if type is a template specialization, we have to replace it with a mangled name
@@ -896,7 +3586,7 @@ bool PassTransformation::TraverseTypeLoc(TypeLoc typeLoc)
         if (isa<SubstTemplateTypeParmType>(type))
         {
             // replace with mapped type
-            this->currentRewriter->ReplaceText(typeLoc.getSourceRange(), typeLoc.getType().getAsString());
+            this->currentRewriter->ReplaceText(typeLoc.getSourceRange(), getOutputTypeSpelling(typeLoc.getType()));
         }
 
         RecursiveASTVisitor::TraverseTypeLoc(typeLoc);
@@ -905,33 +3595,123 @@ bool PassTransformation::TraverseTypeLoc(TypeLoc typeLoc)
     return true;
 }
 
-bool PassTransformation::TraverseCXXOperatorCallExpr(CXXOperatorCallExpr *Expression)
+// value of a non-type template parameter as an OpenCL C literal
+// (bools as 'true'/'false', enums as their integral value)
+PRIVATE std::string getIntegralLiteral(const llvm::APSInt &value, QualType type, ASTContext &context)
+{
+    if (type->isBooleanType())
+    {
+        return (value.getBoolValue() ? "true" : "false");
+    }
+
+    std::string literal = value.toString(10);
+
+    if (!type->isEnumeralType())
+    {
+        if (type->isUnsignedIntegerType())
+        {
+            literal += "u";
+        }
+
+        if (context.getTypeSize(type) > 32)
+        {
+            literal += "l";
+        }
+    }
+
+    // e.g. 'x-N' must not become 'x--1'
+    if (value.isSigned() && value.isNegative())
+    {
+        literal = "(" + literal + ")";
+    }
+
+    return literal;
+}
+
+bool PassTransformation::TraverseSubstNonTypeTemplateParmExpr(SubstNonTypeTemplateParmExpr *Expression)
 {
-    RecursiveASTVisitor::TraverseCXXOperatorCallExpr(Expression);
+    // the source still refers to the template parameter ('N') -> replace it with its value
+    llvm::APSInt value;
+    if (!Expression->getReplacement()->EvaluateAsInt(value, *this->context))
+    {
+        FAIL("unsupported non-type template argument for parameter '" << Expression->getParameter()->getNameAsString()
+             << "' (only integral and enumeration values are supported)");
+    }
+
+    this->currentRewriter->ReplaceText(Expression->getSourceRange(),
+                                       getIntegralLiteral(value, Expression->getType(), *this->context));
 
+    // NOTE: do not traverse the replacement, since it has no source of its own
+    return true;
+}
+
+bool PassTransformation::TraverseCXXOperatorCallExpr(CXXOperatorCallExpr *Expression)
+{
     Decl *calleeDeclaration = Expression->getCalleeDecl();
 
+    // instance of an operator of an empty record, which is evaluated for its side effects only (e.g. 'objs[i++](a, b)')
+    std::string evaluatedInstance;
+
+    if (isa<CXXMethodDecl>(calleeDeclaration) && !this->needsInstance(cast<CXXMethodDecl>(calleeDeclaration)))
+    {
+        // the operator is still required, although its instance is not traversed
+        this->addReference(this->getOutputName(cast<FunctionDecl>(calleeDeclaration)));
+
+        if (!isDroppableInstance(Expression->getArg(0), *this->context))
+        {
+            TraverseStmt(Expression->getArg(0));
+            evaluatedInstance = this->expressionToString(Expression->getArg(0));
+        }
+
+        // NOTE: the instance (first argument) is dropped (unless it has side effects), so it is not traversed
+        for (unsigned argIdx = 1; argIdx < Expression->getNumArgs(); ++argIdx)
+        {
+            TraverseStmt(Expression->getArg(argIdx));
+        }
+    }
+    else
+    {
+        RecursiveASTVisitor::TraverseCXXOperatorCallExpr(Expression);
+    }
+
     if (isa<CXXMethodDecl>(calleeDeclaration))
     {
         CXXMethodDecl *methodDeclaration = cast<CXXMethodDecl>(calleeDeclaration);
 
-        // get mangled name
-        std::string mangledName = PatosNameMangling::getMangledNameForFunction(methodDeclaration);
+        // get mangled name (of the clone for the address spaces of the instance and the arguments)
+        std::string mangledName;
+        {
+            std::vector<const Expr *> arguments;
+            for (unsigned argIdx = 1; argIdx < Expression->getNumArgs(); ++argIdx)
+            {
+                arguments.push_back(Expression->getArg(argIdx));
+            }
+
+            mangledName = this->getCalleeName(methodDeclaration, this->inferStorageAddressSpace(Expression->getArg(0)), arguments);
+        }
 
         // get arguments
         std::string argumentString;
         {
             std::stringstream strstr;
 
+            // methods of empty records do not get an instance
+            // -> omit first argument (e.g. the temporary in 'COMP()(a, b)')
+            unsigned firstArgument = this->needsInstance(methodDeclaration) ? 0 : 1;
+
             // iterate over all arguments
-            for (unsigned argIdx = 0; argIdx < Expression->getNumArgs(); ++argIdx)
+            for (unsigned argIdx = firstArgument; argIdx < Expression->getNumArgs(); ++argIdx)
             {
                 const Expr *argument = Expression->getArg(argIdx);
 
                 // check if we have to get the pointer to the argument
                 // (first argument, i.e. the instance the operator function is called upon)
                 // TODO is this correct?
-                if (argIdx == 0)
+                if (argIdx == 0 && this->passesInstanceByValue(methodDeclaration))
+                {
+                    strstr << "(" << this->expressionToString(argument) << ")";
+                }
+                else if (argIdx == 0)
                 {
                     strstr << "&(" << this->expressionToString(argument) << ")";
                 }
@@ -950,7 +3730,13 @@ bool PassTransformation::TraverseCXXOperatorCallExpr(CXXOperatorCallExpr *Expres
         }
 
         // replace operator call with a normal function call
-        this->currentRewriter->ReplaceText(Expression->getSourceRange(), mangledName + "(" + argumentString + ")");
+        std::string call = mangledName + "(" + argumentString + ")";
+        if (!evaluatedInstance.empty())
+        {
+            call = "((void)(" + evaluatedInstance + "), " + call + ")";
+        }
+
+        this->currentRewriter->ReplaceText(Expression->getSourceRange(), call);
     }
 
     return true;
@@ -966,17 +3752,29 @@ bool PassTransformation::VisitCallExpr(CallExpr *Expression)
         return true;
     }
 
+    if (isa<FunctionDecl>(calleeDeclaration))
+    {
+        this->addReference(this->getOutputName(cast<FunctionDecl>(calleeDeclaration)));
+    }
+
     if (!isa<CXXOperatorCallExpr>(Expression))
     {
         if (isa<FunctionDecl>(calleeDeclaration))
         {
             FunctionDecl *calleeFunctionDeclaration = cast<FunctionDecl>(calleeDeclaration);
 
-            if (calleeFunctionDeclaration->getTemplatedKind() == FunctionDecl::TemplatedKind::TK_FunctionTemplateSpecialization)
+            // get name of the callee (or of its clone for the address spaces of the arguments)
+            std::vector<const Expr *> arguments;
+            for (unsigned argIdx = 0; argIdx < Expression->getNumArgs(); ++argIdx)
             {
-                // get mangled name
-                std::string mangledName = PatosNameMangling::getMangledNameForFunction(calleeFunctionDeclaration);
+                arguments.push_back(Expression->getArg(argIdx));
+            }
+
+            std::string mangledName = this->getCalleeName(calleeFunctionDeclaration, "", arguments);
 
+            if (calleeFunctionDeclaration->getTemplatedKind() == FunctionDecl::TemplatedKind::TK_FunctionTemplateSpecialization ||
+                mangledName != calleeFunctionDeclaration->getNameAsString())
+            {
                 // get source range for callee
                 // unfortunately, clang provides the wrong range for our purpose if explicit template arguments are specified:
                 //    foo<bar>()
@@ -1027,9 +3825,8 @@ bool PassTransformation::TraverseCallExpr(CallExpr *Expression)
 
 bool PassTransformation::TraverseCXXMemberCallExpr(CXXMemberCallExpr *Expression)
 {
-    std::string expressionString = this->expressionToString(Expression);
-
-    DBG << "            member call expression: " << expressionString << std::endl;
+    // NOTE: the expression is only rendered if debug output is enabled
+    DBG << "            member call expression: " << this->expressionToString(Expression) << std::endl;
 
     if (!isa<MemberExpr>(Expression->getCallee()))
     {
@@ -1040,18 +3837,67 @@ bool PassTransformation::TraverseCXXMemberCallExpr(CXXMemberCallExpr *Expression
 
     MemberExpr *Callee = cast<MemberExpr>(Expression->getCallee());
 
+    this->addReference(this->getOutputName(cast<FunctionDecl>(Callee->getMemberDecl())));
+
+    // method called on an element of a struct of arrays -> pass arrays and index
+    {
+        std::string prefix, index, addressSpace;
+        if (isa<CXXMethodDecl>(Callee->getMemberDecl()) && this->getStructOfArraysElement(Callee, prefix, index, addressSpace))
+        {
+            CXXMethodDecl *method = cast<CXXMethodDecl>(Callee->getMemberDecl());
+
+            std::string instanceArguments = this->getStructOfArraysArguments(method->getParent(), prefix, index);
+            if (Expression->getNumArgs() > 0)
+            {
+                this->currentRewriter->InsertTextBefore(Expression->getArg(0)->getLocStart(), instanceArguments + ", ");
+            }
+            else
+            {
+                this->currentRewriter->InsertTextBefore(Expression->getRParenLoc(), instanceArguments);
+            }
+
+            this->currentRewriter->ReplaceText(Callee->getSourceRange(), this->requestStructOfArraysClone(method, addressSpace));
+
+            for (auto it = Expression->arg_begin(); it != Expression->arg_end(); ++it)
+            {
+                TraverseStmt(*it);
+            }
+
+            return true;
+        }
+    }
+
     // 1) additional argument (thisRef)
+    // NOTE: methods of empty records do not get an instance
+    CXXMethodDecl *calleeMethod = dyn_cast<CXXMethodDecl>(Callee->getMemberDecl());
+    if (calleeMethod == NULL || this->needsInstance(calleeMethod))
     {
+        bool calleeByValue = (calleeMethod != NULL) && this->passesInstanceByValue(calleeMethod);
+
         std::string calleeRecord;
         if (Callee->getBase()->isImplicitCXXThis() || isa<CXXThisExpr>(Callee->getBase()))
         {
-            calleeRecord = "thisRef";
+            if (this->currentInstanceByValue)
+            {
+                calleeRecord = calleeByValue ? "thisVal" : "&thisVal";
+            }
+            else
+            {
+                calleeRecord = calleeByValue ? "*thisRef" : "thisRef";
+            }
         }
         else
         {
+            // translate the base first (e.g. nested operator calls or temporaries of value types)
+            TraverseStmt(Callee->getBase());
+
             calleeRecord = expressionToString(Callee->getBase());
 
-            if (!Callee->isArrow())
+            if (calleeByValue && Callee->isArrow())
+            {
+                calleeRecord = "*(" + calleeRecord + ")";
+            }
+            else if (!calleeByValue && !Callee->isArrow())
             {
                 calleeRecord = "&" + calleeRecord;
             }
@@ -1070,9 +3916,26 @@ bool PassTransformation::TraverseCXXMemberCallExpr(CXXMemberCallExpr *Expression
         }
     }
 
+    // the instance of a method of an empty record is dropped, unless it has side effects (e.g. 'makeComp().cmp(a, b)')
+    std::string evaluatedInstance;
+    if (calleeMethod != NULL && !this->needsInstance(calleeMethod) && !isDroppableInstance(Callee->getBase(), *this->context))
+    {
+        TraverseStmt(Callee->getBase());
+        evaluatedInstance = expressionToString(Callee->getBase());
+    }
+
     // 2) replace callee
     {
-        std::string mangledName = PatosNameMangling::getMangledNameForFunction(cast<FunctionDecl>(Callee->getMemberDecl()));
+        // the instance is stored where the base points into ('->') or where the base is stored ('.')
+        std::string thisAddressSpace = Callee->isArrow() ? this->inferAddressSpace(Callee->getBase()) : this->inferStorageAddressSpace(Callee->getBase());
+
+        std::vector<const Expr *> arguments;
+        for (unsigned argIdx = 0; argIdx < Expression->getNumArgs(); ++argIdx)
+        {
+            arguments.push_back(Expression->getArg(argIdx));
+        }
+
+        std::string mangledName = this->getCalleeName(cast<FunctionDecl>(Callee->getMemberDecl()), thisAddressSpace, arguments);
         DBG << "               -> replace with call to: " << mangledName << std::endl;
         this->currentRewriter->ReplaceText(Callee->getSourceRange(), mangledName);
     }
@@ -1086,15 +3949,76 @@ bool PassTransformation::TraverseCXXMemberCallExpr(CXXMemberCallExpr *Expression
         TraverseStmt(argument);
     }
 
+    if (!evaluatedInstance.empty())
+    {
+        std::string call = this->currentRewriter->getRewrittenText(Expression->getSourceRange());
+        this->currentRewriter->ReplaceText(Expression->getSourceRange(), "((void)(" + evaluatedInstance + "), " + call + ")");
+    }
+
+    return true;
+}
+
+bool PassTransformation::TraverseMemberExpr(MemberExpr *Expression)
+{
+    // access to a field of an element of a struct of arrays: items[i].x -> items_x[i]
+    std::string prefix, index, addressSpace;
+    if (isa<FieldDecl>(Expression->getMemberDecl()) && this->getStructOfArraysElement(Expression, prefix, index, addressSpace))
+    {
+        this->currentRewriter->ReplaceText(Expression->getSourceRange(),
+                                           prefix + "_" + Expression->getMemberDecl()->getNameAsString() + "[" + index + "]");
+
+        // NOTE: do not traverse the base, since the element does not exist as a whole
+        return true;
+    }
+
+    return RecursiveASTVisitor::TraverseMemberExpr(Expression);
+}
+
+bool PassTransformation::VisitDeclRefExpr(DeclRefExpr *Expression)
+{
+    if (this->structOfArraysParameters.find(Expression->getDecl()) != this->structOfArraysParameters.end())
+    {
+        FAIL("parameter '" << Expression->getDecl()->getNameAsString() << "' is passed as struct of arrays and can only be used "
+             "to access fields or to call methods of its elements (items[i].x, items[i].foo(), items->x)");
+    }
+
+    // constants of enums and global variables are required by amalgamated kernels using them
+    ValueDecl *declaration = Expression->getDecl();
+    if (isa<EnumConstantDecl>(declaration) || (isa<VarDecl>(declaration) && cast<VarDecl>(declaration)->isFileVarDecl()))
+    {
+        this->addReference(declaration->getNameAsString());
+    }
+
     return true;
 }
 
 bool PassTransformation::VisitCXXThisExpr(CXXThisExpr *Expression)
 {
-    std::string expressionSource = expressionToString(Expression);
-    DBG << "            'this' expression: " << expressionSource << std::endl;
+    DBG << "            'this' expression: " << expressionToString(Expression) << std::endl;
+
+    if (this->currentClone != NULL && this->currentClone->StructOfArraysRecord != NULL)
+    {
+        FAIL("instance of a method called on an element of a struct of arrays can only be used to access fields or to call methods");
+    }
 
-    if (Expression->isImplicitCXXThis())
+    if (this->currentWithoutInstance)
+    {
+        FAIL("methods of records without fields do not get an instance ('this' can only be used to call their methods)");
+    }
+
+    if (this->currentInstanceByValue)
+    {
+        // instance has been passed by value
+        if (Expression->isImplicitCXXThis())
+        {
+            this->currentRewriter->InsertTextBefore(Expression->getLocStart(), "thisVal.");
+        }
+        else
+        {
+            this->currentRewriter->ReplaceText(Expression->getSourceRange(), "(&thisVal)");
+        }
+    }
+    else if (Expression->isImplicitCXXThis())
     {
         this->currentRewriter->InsertTextBefore(Expression->getLocStart(), "thisRef->");
     }
@@ -1108,16 +4032,61 @@ bool PassTransformation::VisitCXXThisExpr(CXXThisExpr *Expression)
 
 bool PassTransformation::TraverseVarDecl(VarDecl *Declaration)
 {
+    // a variable declared in a block can be initialized in place by a statement following its declaration
+    CXXConstructExpr *inPlaceConstruction = NULL;
+    SourceLocation locationAfterDeclaration;
+    if (Declaration->getInitStyle() == VarDecl::InitializationStyle::CallInit &&
+        Declaration->getInit() != NULL && isa<CXXConstructExpr>(Declaration->getInit()) &&
+        this->blockScopeVariables.find(Declaration) != this->blockScopeVariables.end() &&
+        this->constructsInPlace(cast<CXXConstructExpr>(Declaration->getInit())->getConstructor()))
+    {
+        SourceManager &sourceManager = this->context->getSourceManager();
+        const LangOptions &languageOptions = this->context->getLangOpts();
+
+        locationAfterDeclaration = Lexer::findLocationAfterToken(Declaration->getLocEnd(), tok::semi, sourceManager, languageOptions, true);
+        if (locationAfterDeclaration.isValid())
+        {
+            inPlaceConstruction = cast<CXXConstructExpr>(Declaration->getInit());
+            this->inPlaceTargets[inPlaceConstruction] = Declaration->getNameAsString();
+        }
+    }
+
     RecursiveASTVisitor::TraverseVarDecl(Declaration);
 
+    if (inPlaceConstruction != NULL)
+    {
+        // X x(a, b);  ->  struct X x; X_inplace(&x, a, b);
+        SourceRange parenRange = inPlaceConstruction->getParenOrBraceRange();
+        if (parenRange.isValid())
+        {
+            this->currentRewriter->RemoveText(parenRange);
+        }
+
+        this->currentRewriter->InsertTextAfter(locationAfterDeclaration, "\n\t" + this->inPlaceCalls[inPlaceConstruction] + ";");
+
+        return true;
+    }
+
+    // a local pointer initialized with a pointer into another address space has to point into this address space, too
+    if (Declaration->isLocalVarDecl() && Declaration->getType()->isPointerType() &&
+        Declaration->getInit() != NULL && this->getAnnotatedAddressSpace(Declaration).empty())
+    {
+        std::string addressSpace = this->inferAddressSpace(Declaration->getInit());
+        this->pointerAddressSpaces[Declaration] = addressSpace;
+
+        if (addressSpace != PATOS_PRIVATE_ADDRESS_SPACE)
+        {
+            this->currentRewriter->InsertTextBefore(Declaration->getLocStart(), addressSpace + " ");
+        }
+    }
+
     if (Declaration->getInitStyle() == VarDecl::InitializationStyle::CallInit)
     {
         Expr *initExpression = Declaration->getInit();
 
         if (initExpression == NULL || !isa<CXXConstructExpr>(initExpression))
         {
-            ERROR << "unknown initialization of variable '" << Declaration->getNameAsString() << "'" << std::endl;
-            exit(EXIT_FAILURE);
+            FAIL("unknown initialization of variable '" << Declaration->getNameAsString() << "'");
         }
         
         CXXConstructExpr *constructExpression = cast<CXXConstructExpr>(initExpression);
@@ -1153,16 +4122,36 @@ bool PassTransformation::TraverseCXXConstructExpr(CXXConstructExpr *Expression)
 
     CXXConstructorDecl *constructorDeclaration = Expression->getConstructor();
 
-    if (constructorDeclaration == NULL || constructorDeclaration->isImplicit())
+    if (constructorDeclaration == NULL)
     {
         return true;
     }
 
+    this->addReference(this->getOutputName(constructorDeclaration->getParent()));
+
+    if (constructorDeclaration->isImplicit())
+    {
+        return true;
+    }
+
+    // constructions initializing a variable in place call the in-place variant of the constructor
+    auto itInPlace = this->inPlaceTargets.find(Expression);
+    bool inPlace = (itInPlace != this->inPlaceTargets.end());
+
+    std::string constructorName = this->getOutputName(constructorDeclaration) + (inPlace ? "_inplace" : "");
+    this->addReference(constructorName);
+
     // build call to 'constructor' function
     std::stringstream constructorCall;
     {
-        constructorCall << PatosNameMangling::getMangledNameForFunction(constructorDeclaration) << "(";
+        constructorCall << constructorName << "(";
         unsigned numArgs = Expression->getNumArgs();
+
+        if (inPlace)
+        {
+            constructorCall << "&" << itInPlace->second << (numArgs > 0 ? ", " : "");
+        }
+
         for (unsigned argIdx = 0; argIdx < numArgs; ++argIdx)
         {
             constructorCall << this->expressionToString(Expression->getArg(argIdx));
@@ -1175,6 +4164,13 @@ bool PassTransformation::TraverseCXXConstructExpr(CXXConstructExpr *Expression)
         constructorCall << ")";
     }
 
+    if (inPlace)
+    {
+        // the caller places the call after the declaration of the target
+        this->inPlaceCalls[Expression] = constructorCall.str();
+        return true;
+    }
+
     SourceRange range = Expression->getParenOrBraceRange();
     if (range.isValid())
     {
@@ -1193,6 +4189,286 @@ bool PassTransformation::TraverseCXXConstructExpr(CXXConstructExpr *Expression)
     return true;
 }
 
+// loops annotated with '__unroll(N)' are preceded by 'if (0 && "__patos__unroll" && (N)) ; else'
+// -> returns the unroll factor N (NULL if the statement is no such annotation)
+PRIVATE Expr *getUnrollFactor(IfStmt *Statement)
+{
+    if (Statement->getElse() == NULL || !isa<NullStmt>(Statement->getThen()))
+    {
+        return NULL;
+    }
+
+    // condition: (0 && "__patos__unroll") && (N)
+    BinaryOperator *condition = dyn_cast<BinaryOperator>(Statement->getCond()->IgnoreParenImpCasts());
+    if (condition == NULL || condition->getOpcode() != BO_LAnd)
+    {
+        return NULL;
+    }
+
+    BinaryOperator *marker = dyn_cast<BinaryOperator>(condition->getLHS()->IgnoreParenImpCasts());
+    if (marker == NULL || marker->getOpcode() != BO_LAnd)
+    {
+        return NULL;
+    }
+
+    StringLiteral *annotation = dyn_cast<StringLiteral>(marker->getRHS()->IgnoreParenImpCasts());
+    if (annotation == NULL || annotation->getString() != PATOS_UNROLL_ANNOTATION)
+    {
+        return NULL;
+    }
+
+    return condition->getRHS();
+}
+
+class ASTVisitorUnrollBody: public RecursiveASTVisitor<ASTVisitorUnrollBody>
+{
+private:
+    const VarDecl *counter;
+
+    bool isCounter(Expr *Expression)
+    {
+        DeclRefExpr *reference = dyn_cast<DeclRefExpr>(Expression->IgnoreParenImpCasts());
+
+        return reference != NULL && reference->getDecl() == this->counter;
+    }
+
+public:
+    // body can be copied for each iteration (with a constant counter)
+    bool unrollable;
+
+    ASTVisitorUnrollBody(const VarDecl *counter):
+        counter(counter),
+        unrollable(true)
+    {
+        // intentionally left blank
+    }
+
+    // NOTE: 'break' and 'continue' of nested loops would be fine, but we keep it simple
+    bool VisitBreakStmt(BreakStmt *Statement)
+    {
+        this->unrollable = false;
+        return true;
+    }
+
+    bool VisitContinueStmt(ContinueStmt *Statement)
+    {
+        this->unrollable = false;
+        return true;
+    }
+
+    // labels would be duplicated
+    bool VisitLabelStmt(LabelStmt *Statement)
+    {
+        this->unrollable = false;
+        return true;
+    }
+
+    bool VisitUnaryOperator(UnaryOperator *Expression)
+    {
+        if ((Expression->isIncrementDecrementOp() || Expression->getOpcode() == UO_AddrOf) && this->isCounter(Expression->getSubExpr()))
+        {
+            this->unrollable = false;
+        }
+
+        return true;
+    }
+
+    bool VisitBinaryOperator(BinaryOperator *Expression)
+    {
+        if (Expression->isAssignmentOp() && this->isCounter(Expression->getLHS()))
+        {
+            this->unrollable = false;
+        }
+
+        return true;
+    }
+};
+
+// maximum number of copies of a loop body if a loop is unrolled completely ('__unroll(0)')
+#define PATOS_MAX_UNROLLED_ITERATIONS 256
+
+// values of the counter of a loop 'for (T i = A; i < B; ++i)' with constant bounds and step
+// (false if the loop is not of this form or has more than maxIterations iterations)
+bool PassTransformation::getConstantIterations(ForStmt *Loop, unsigned long maxIterations, const VarDecl *&counter, std::vector<long long> &values)
+{
+    // initialization: T i = A
+    DeclStmt *initialization = dyn_cast_or_null<DeclStmt>(Loop->getInit());
+    if (initialization == NULL || !initialization->isSingleDecl() || !isa<VarDecl>(initialization->getSingleDecl()))
+    {
+        return false;
+    }
+
+    counter = cast<VarDecl>(initialization->getSingleDecl());
+
+    llvm::APSInt value;
+    if (!counter->getType()->isIntegerType() || counter->getInit() == NULL || !counter->getInit()->EvaluateAsInt(value, *this->context))
+    {
+        return false;
+    }
+
+    long long start = value.getSExtValue();
+
+    // condition: i < B (or <=, >, >=, !=)
+    BinaryOperator *condition = dyn_cast_or_null<BinaryOperator>(Loop->getCond());
+    if (condition == NULL || !condition->isComparisonOp() || condition->getOpcode() == BO_EQ)
+    {
+        return false;
+    }
+
+    DeclRefExpr *conditionCounter = dyn_cast<DeclRefExpr>(condition->getLHS()->IgnoreParenImpCasts());
+    if (conditionCounter == NULL || conditionCounter->getDecl() != counter || !condition->getRHS()->EvaluateAsInt(value, *this->context))
+    {
+        return false;
+    }
+
+    long long bound = value.getSExtValue();
+
+    // increment: ++i, i++, --i, i--, i += C, i -= C
+    long long step = 0;
+    Expr *increment = Loop->getInc();
+    if (increment != NULL && isa<UnaryOperator>(increment) && cast<UnaryOperator>(increment)->isIncrementDecrementOp())
+    {
+        UnaryOperator *unary = cast<UnaryOperator>(increment);
+        DeclRefExpr *incrementCounter = dyn_cast<DeclRefExpr>(unary->getSubExpr()->IgnoreParenImpCasts());
+
+        if (incrementCounter == NULL || incrementCounter->getDecl() != counter)
+        {
+            return false;
+        }
+
+        step = unary->isIncrementOp() ? 1 : -1;
+    }
+    else if (increment != NULL && isa<CompoundAssignOperator>(increment))
+    {
+        CompoundAssignOperator *assignment = cast<CompoundAssignOperator>(increment);
+        DeclRefExpr *incrementCounter = dyn_cast<DeclRefExpr>(assignment->getLHS()->IgnoreParenImpCasts());
+
+        if (incrementCounter == NULL || incrementCounter->getDecl() != counter || !assignment->getRHS()->EvaluateAsInt(value, *this->context))
+        {
+            return false;
+        }
+
+        if (assignment->getOpcode() == BO_AddAssign)
+        {
+            step = value.getSExtValue();
+        }
+        else if (assignment->getOpcode() == BO_SubAssign)
+        {
+            step = -value.getSExtValue();
+        }
+    }
+
+    if (step == 0)
+    {
+        return false;
+    }
+
+    // simulate the loop
+    values.clear();
+    for (long long current = start; ; current += step)
+    {
+        bool continueLoop = false;
+        switch (condition->getOpcode())
+        {
+            case BO_LT: continueLoop = (current <  bound); break;
+            case BO_LE: continueLoop = (current <= bound); break;
+            case BO_GT: continueLoop = (current >  bound); break;
+            case BO_GE: continueLoop = (current >= bound); break;
+            case BO_NE: continueLoop = (current != bound); break;
+            default: break;
+        }
+
+        if (!continueLoop)
+        {
+            break;
+        }
+
+        if (values.size() >= maxIterations)
+        {
+            return false;
+        }
+
+        values.push_back(current);
+    }
+
+    // the body must not change the counter and has to be executed for every iteration
+    ASTVisitorUnrollBody visitor(counter);
+    visitor.TraverseStmt(Loop->getBody());
+
+    return visitor.unrollable;
+}
+
+bool PassTransformation::TraverseIfStmt(IfStmt *Statement)
+{
+    Expr *factorExpression = getUnrollFactor(Statement);
+    if (factorExpression == NULL)
+    {
+        return RecursiveASTVisitor::TraverseIfStmt(Statement);
+    }
+
+    Stmt *loop = Statement->getElse();
+    if (!isa<ForStmt>(loop) && !isa<WhileStmt>(loop) && !isa<DoStmt>(loop))
+    {
+        FAIL("'__unroll' has to be followed by a loop");
+    }
+
+    // the factor may depend on template parameters, i.e. it is constant after substitution
+    llvm::APSInt factorValue;
+    if (!factorExpression->EvaluateAsInt(factorValue, *this->context) || factorValue.isNegative())
+    {
+        FAIL("unroll factor '" << this->expressionToString(factorExpression) << "' is not a non-negative constant");
+    }
+
+    unsigned long factor = factorValue.getZExtValue();
+
+    // transform the loop itself first
+    TraverseStmt(loop);
+
+    SourceManager &sourceManager = this->context->getSourceManager();
+    std::pair<SourceLocation, SourceLocation> markerRange = sourceManager.getExpansionRange(Statement->getLocStart());
+
+    // loop with a constant number of iterations (not more than the factor) -> copy body for each iteration
+    const VarDecl *counter = NULL;
+    std::vector<long long> values;
+    if (isa<ForStmt>(loop) &&
+        this->getConstantIterations(cast<ForStmt>(loop), (factor == 0) ? PATOS_MAX_UNROLLED_ITERATIONS : factor, counter, values))
+    {
+        ForStmt *forLoop = cast<ForStmt>(loop);
+
+        std::string counterType = this->currentRewriter->getRewrittenText(counter->getTypeSourceInfo()->getTypeLoc().getSourceRange());
+        std::string body = this->currentRewriter->getRewrittenText(forLoop->getBody()->getSourceRange());
+        if (!isa<CompoundStmt>(forLoop->getBody()))
+        {
+            body += ";";
+        }
+
+        std::stringstream unrolled;
+        unrolled << "/* BEGIN UNROLLED LOOP */\n\t";
+        for (auto it = values.begin(); it != values.end(); ++it)
+        {
+            unrolled << "{ const " << counterType << " " << counter->getNameAsString() << " = " << *it << "; " << body << " }\n\t";
+        }
+        unrolled << "/* END UNROLLED LOOP */";
+
+        DBG << "            unrolled loop with " << values.size() << " iterations" << std::endl;
+
+        this->currentRewriter->ReplaceText(SourceRange(markerRange.first, forLoop->getLocEnd()), unrolled.str());
+
+        return true;
+    }
+
+    // let the OpenCL compiler unroll the loop
+    std::string pragma = "\n#pragma unroll";
+    if (factor > 0)
+    {
+        pragma += " " + std::to_string(factor);
+    }
+
+    this->currentRewriter->ReplaceText(SourceRange(markerRange.first, markerRange.second), pragma + "\n\t");
+
+    return true;
+}
+
 bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
 {
     for (auto stmtIt = Block->body_begin(); stmtIt != Block->body_end(); ++stmtIt)
@@ -1205,6 +4481,12 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
             continue;
         }
 
+        if (isa<DeclStmt>(statement) && cast<DeclStmt>(statement)->isSingleDecl() &&
+            isa<VarDecl>(cast<DeclStmt>(statement)->getSingleDecl()))
+        {
+            this->blockScopeVariables.insert(cast<VarDecl>(cast<DeclStmt>(statement)->getSingleDecl()));
+        }
+
         // find usages of temporary objects
         std::vector<Expr *> temporaryObjects;
         if (this->findUsagesOfTemporaryObjects(statement, temporaryObjects))
@@ -1227,16 +4509,14 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
 
                         if (type == NULL)
                         {
-                            ERROR << "temporary expression does not have a known type" << std::endl;
-                            exit(EXIT_FAILURE);
+                            FAIL("temporary expression does not have a known type");
                         }
 
                         CXXRecordDecl *recordDeclaration = type->getAsCXXRecordDecl();
 
                         if (recordDeclaration == NULL)
                         {
-                            ERROR << "type of temporary object is not a record type" << std::endl;
-                            exit(EXIT_FAILURE);
+                            FAIL("type of temporary object is not a record type");
                         }
 
                         if (isa<ClassTemplateSpecializationDecl>(recordDeclaration))
@@ -1272,8 +4552,7 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
 
                         if (constructExpression == NULL)
                         {
-                            ERROR << "did not find a call to a constructor for temporary object" << std::endl;
-                            exit(EXIT_FAILURE);
+                            FAIL("did not find a call to a constructor for temporary object");
                         }
 
                         CXXConstructorDecl *constructorDeclaration = constructExpression->getConstructor();
@@ -1281,6 +4560,13 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
                         // if used constructor is not implicit, we have to add a call to the 'constructor' function
                         if (!constructorDeclaration->isImplicit())
                         {
+                            // large temporaries are initialized in place
+                            bool inPlace = this->constructsInPlace(constructorDeclaration);
+                            if (inPlace)
+                            {
+                                this->inPlaceTargets[constructExpression] = this->getNameForTemporaryObject(*tempIt);
+                            }
+
                             // we do not want the changes we will make to the construct expression to be 'visible' later on
                             // -> work with a new rewriter instance
 
@@ -1295,7 +4581,14 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
                             // transform construct expression
                             TraverseCXXConstructExpr(constructExpression);
 
-                            prologue << " = " << constructRewriter.getRewrittenText(constructExpression->getParenOrBraceRange());
+                            if (inPlace)
+                            {
+                                prologue << ";\n\t" << this->inPlaceCalls[constructExpression];
+                            }
+                            else
+                            {
+                                prologue << " = " << constructRewriter.getRewrittenText(constructExpression->getParenOrBraceRange());
+                            }
 
                             // restore old state
                             this->currentRewriter = oldRewriter;
@@ -1335,13 +4628,48 @@ bool PassTransformation::TraverseCompoundStmt(CompoundStmt *Block)
     return true;
 }
 
+// replaces a temporary of a value type with the call to the 'constructor' function,
+// e.g. 'V(x, y) * s' -> '__Patos_V__operator__star(__Patos_V__constructor(x, y), s)'
+void PassTransformation::replaceValueTemporary(Expr *Expression)
+{
+    CXXConstructExpr *constructExpression = getTemporaryConstructExpr(Expression);
+
+    // transform construct expression with a new rewriter (as for the helper variables of temporary objects)
+    Rewriter *oldRewriter = this->currentRewriter;
+
+    Rewriter constructRewriter;
+    constructRewriter.setSourceMgr(this->context->getSourceManager(), this->context->getLangOpts());
+    this->currentRewriter = &constructRewriter;
+
+    TraverseCXXConstructExpr(constructExpression);
+
+    std::string constructorCall = constructRewriter.getRewrittenText(constructExpression->getParenOrBraceRange());
+
+    this->currentRewriter = oldRewriter;
+
+    this->currentRewriter->ReplaceText(Expression->getSourceRange(), constructorCall);
+}
+
 bool PassTransformation::TraverseCXXFunctionalCastExpr(CXXFunctionalCastExpr *Expression)
 {
+    // temporary of an empty record a method is called on
+    // -> not created at all (the call is replaced as a whole)
+    if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end() && isElidableTemporary(Expression))
+    {
+        return true;
+    }
+
+    // temporary of a value type without a helper variable
+    if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end() && isValueTemporary(Expression))
+    {
+        this->replaceValueTemporary(Expression);
+        return true;
+    }
+
     // check we identified this expression as CXXFunctionalCastExpr earlier
     if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end())
     {
-        ERROR << "did not find temporary object earlier (internal error)" << std::endl;
-        exit(EXIT_FAILURE);
+        FAIL("did not find temporary object earlier (internal error)");
     }
 
     // replace expression with the name of the local variable we inserted for this temporary
@@ -1356,11 +4684,24 @@ bool PassTransformation::TraverseCXXFunctionalCastExpr(CXXFunctionalCastExpr *Ex
 
 bool PassTransformation::TraverseCXXTemporaryObjectExpr(CXXTemporaryObjectExpr *Expression)
 {
+    // temporary of an empty record a method is called on
+    // -> not created at all (the call is replaced as a whole)
+    if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end() && isElidableTemporary(Expression))
+    {
+        return true;
+    }
+
+    // temporary of a value type without a helper variable
+    if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end() && isValueTemporary(Expression))
+    {
+        this->replaceValueTemporary(Expression);
+        return true;
+    }
+
     // check we identified this expression as CXXFunctionalCastExpr earlier
     if (this->temporaryObjectNames.find(Expression) == this->temporaryObjectNames.end())
     {
-        ERROR << "did not find temporary object earlier (internal error)" << std::endl;
-        exit(EXIT_FAILURE);
+        FAIL("did not find temporary object earlier (internal error)");
     }
 
     // replace expression with the name of the local variable we inserted for this temporary
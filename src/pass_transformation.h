@@ -24,12 +24,16 @@
 #include <sstream>
 #include <set>
 #include <map>
+#include <algorithm>
+#include <utility>
 
 #include "commandline.h"
 #include "common.h"
 #include "patos_consumer.h"
 #include "file_handling.h"
 #include "name_mangling.h"
+#include "parse.h"
+#include "translation_results.h"
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
@@ -40,6 +44,7 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/Attr.h"
+#include "clang/AST/RecordLayout.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/Lexer.h"
 
@@ -54,12 +59,115 @@ private:
 
     std::set<std::string> &templateFiles;
 
+    TranslationResults &results;
+
+    // macros the file is parsed with (written to amalgamated kernels)
+    std::vector<MacroDefinition> macros;
+
     ClassTemplateDecl *currentClassTemplate;
     Rewriter *currentRewriter;
 
     int temporaryObjectCounter;
     std::map<Expr *, std::string> temporaryObjectNames;
 
+    // function/record whose code is currently traversed
+    std::string currentOwner;
+
+    // functions/records referenced by each function/record (by output name)
+    std::map<std::string, std::set<std::string>> references;
+
+    std::set<std::string> kernelFunctions;
+
+    // size of the generated code for each function/record (by output name)
+    std::map<std::string, unsigned long> generatedBytes;
+
+    std::map<std::string, SpecializationInfo> emittedSpecializations;
+
+    // identical code folding: first definition for each signature (without name) and body,
+    // along with the name of its record (if the record does not matter for the body)
+    std::map<std::string, std::pair<std::string, std::string>> foldedDefinitions;
+
+    // clone of a function/method for the address spaces its pointer arguments point into
+    struct AddressSpaceClone
+    {
+        FunctionDecl *Declaration;
+        // address space of the instance (methods only)
+        std::string ThisAddressSpace;
+        // address space of each parameter (empty if the parameter is not cloned)
+        std::vector<std::string> ParameterAddressSpaces;
+        // appended to the output name of the function
+        std::string Suffix;
+        // record of a method called on an element of a struct of arrays (NULL for other clones)
+        // along with the address space of the arrays
+        const CXXRecordDecl *StructOfArraysRecord;
+        std::string StructOfArraysAddressSpace;
+    };
+
+    // requested clones (by name) and the order in which they have been requested
+    std::map<std::string, AddressSpaceClone> requestedClones;
+    std::vector<std::string> cloneWorklist;
+
+    // clone which is currently emitted (NULL while transforming the original functions)
+    const AddressSpaceClone *currentClone;
+
+    // instance of the current method is passed by value (thisVal) instead of by pointer (thisRef)
+    bool currentInstanceByValue;
+
+    // current method does not get an instance at all (see needsInstance())
+    bool currentWithoutInstance;
+
+    // in-place variant of the current constructor is emitted (initializing *thisRef)
+    bool currentConstructorInPlace;
+
+    // variables declared directly in a block (i.e. not in the head of a loop, ...)
+    std::set<const VarDecl *> blockScopeVariables;
+
+    // constructions initializing a variable in place: target variable and call of the in-place constructor
+    std::map<const CXXConstructExpr *, std::string> inPlaceTargets;
+    std::map<const CXXConstructExpr *, std::string> inPlaceCalls;
+
+    // functions called inside loops (canonical declarations)
+    std::set<const FunctionDecl *> calledInsideLoops;
+
+    // records whose layout has to be kept, e.g. because they are shared with the host (along with the reason)
+    std::map<const RecordDecl *, std::string> fixedLayoutRecords;
+
+    // kernel parameters passed as struct of arrays (along with the address space of the arrays)
+    std::map<const ValueDecl *, std::string> structOfArraysParameters;
+
+    // kind of generated code
+    enum CodeKind
+    {
+        CODE_DATA,          // declarations kept in place (records without methods, enums, typedefs, variables)
+        CODE_RECORD,        // flattened records
+        CODE_PROTOTYPE,
+        CODE_FUNCTION,      // functions kept in place
+        CODE_DEFINITION
+    };
+
+    // generated code (prototypes, definitions, flattened records) along with the function/record
+    // it belongs to, inserted at the end if unreachable code is pruned or kernels are amalgamated
+    struct PendingCode
+    {
+        SourceLocation Location;
+        std::string Code;
+        std::string Owner;
+        CodeKind Kind;
+        // records contained by value (records and data only)
+        std::set<std::string> Dependencies;
+        // end of the declaration the code has been taken from (data and functions kept in place only)
+        SourceLocation End;
+        // names declared by the code, e.g. the constants of an enum (data only)
+        std::set<std::string> Names;
+        // typedefs, enums, records and variables used by the code (data only)
+        std::set<std::string> Uses;
+    };
+
+    std::vector<PendingCode> pendingCode;
+
+    // address spaces inferred for pointer parameters/variables of the current function
+    std::map<const ValueDecl *, std::string> pointerAddressSpaces;
+
     std::string expressionToString(const Expr *Expression);
     
     SourceLocation getRealEndLocationForFunctionDeclaration(FunctionDecl *Declaration);
@@ -68,14 +176,36 @@ private:
 
     std::string createFlatVersionOfRecord(CXXRecordDecl *Declaration);
 
+    void findRecordsWithFixedLayout(TranslationUnitDecl *TranslationUnit);
+
+    void markRecordsWithFixedLayout(QualType type, const std::string &reason);
+
+    void optimizeRecordLayout(CXXRecordDecl *Declaration, const std::string &recordName, const std::vector<FieldDecl *> &fields, std::vector<unsigned> &order);
+
     void removeDeclarationOrRememberToRemoveInTheFuture(Decl *Declaration);
 
     SourceRange getSignatureSourceRange(FunctionDecl *Declaration);
 
     bool isKernelFunction(FunctionDecl *Declaration);
 
+    bool passesInstanceByValue(CXXMethodDecl *Declaration);
+
+    bool needsInstance(CXXMethodDecl *Declaration);
+
+    bool constructsInPlace(CXXConstructorDecl *Declaration);
+
+    void findFunctionsCalledInsideLoops(TranslationUnitDecl *TranslationUnit);
+
+    bool isAlwaysInlined(FunctionDecl *Declaration);
+
+    void eliminateRecursion(FunctionDecl *Declaration);
+
+    bool getConstantIterations(ForStmt *Loop, unsigned long maxIterations, const VarDecl *&counter, std::vector<long long> &values);
+
     void transformFunction(FunctionDecl *Declaration, const SourceLocation &insertLocation, bool addDefinitionToMainFile = false);
 
+    bool foldIdenticalDefinition(FunctionDecl *Declaration, const std::string &signatureSource, std::string &bodySource);
+
     bool hasAlreadyADeclaration(const std::string &declarationName);
 
     // NOTE: this method returns a source range *including* the opening parenthesis of the call expression
@@ -88,20 +218,83 @@ private:
 
     std::string getNameForTemporaryObject(Expr *Expression);
 
+    void replaceValueTemporary(Expr *Expression);
+
     bool hasAlreadyATypeDef(const std::string &recordName);
 
+    std::string getSourceLine(SourceLocation location);
+
+    void getSpecializations(ClassTemplateDecl *Declaration, std::vector<ClassTemplateSpecializationDecl *> &result);
+
+    void getSpecializations(FunctionTemplateDecl *Declaration, std::vector<FunctionDecl *> &result);
+
+    std::string getOutputName(RecordDecl *Declaration);
+
+    std::string getOutputName(FunctionDecl *Declaration);
+
+    std::string getEmittedName(FunctionDecl *Declaration);
+
+    std::string getAnnotatedAddressSpace(const Decl *Declaration);
+
+    std::string inferAddressSpace(const Expr *Expression);
+
+    std::string inferStorageAddressSpace(const Expr *Expression);
+
+    std::string getCalleeName(FunctionDecl *Callee, const std::string &thisAddressSpace, const std::vector<const Expr *> &arguments);
+
+    void emitAddressSpaceClone(const AddressSpaceClone &clone);
+
+    bool isStructOfArraysRecord(const CXXRecordDecl *Declaration);
+
+    const CXXRecordDecl *getStructOfArraysPointee(QualType type);
+
+    std::string getStructOfArraysParameters(const CXXRecordDecl *Record, const std::string &prefix, const std::string &addressSpace, bool isConst);
+
+    std::string getStructOfArraysArguments(const CXXRecordDecl *Record, const std::string &prefix, const std::string &index);
+
+    bool getStructOfArraysElement(MemberExpr *Expression, std::string &prefix, std::string &index, std::string &addressSpace);
+
+    std::string requestStructOfArraysClone(CXXMethodDecl *Method, const std::string &addressSpace);
+
+    void addReference(const std::string &name);
+
+    void emitCode(const SourceLocation &location, const std::string &code, const std::string &owner, CodeKind kind, const RecordDecl *record = NULL);
+
+    void getValueDependencies(QualType type, std::set<std::string> &dependencies);
+
+    void getTypeUses(QualType type, std::set<std::string> &uses);
+
+    void getReachable(const std::vector<std::string> &roots, std::set<std::string> &reachable);
+
+    void emitPendingCode();
+
+    void writeAmalgamatedKernels();
+
+    void addGeneratedCode(const std::string &owner, unsigned long bytes);
+
+    void registerSpecialization(const std::string &templateName, bool isClassTemplate, const std::string &mangledName);
+
+    void recordResults();
+
 public:
-    PassTransformation(std::string &FileName, struct Arguments &arguments, std::set<std::string> &templateFiles):
+    PassTransformation(std::string &FileName, struct Arguments &arguments, std::set<std::string> &templateFiles, TranslationResults &results,
+                       const std::vector<MacroDefinition> &macros = std::vector<MacroDefinition>()):
         PatosConsumer(FileName, arguments),
         templateFiles(templateFiles),
+        results(results),
+        macros(macros),
         currentClassTemplate(NULL),
         currentRewriter(NULL),
-        temporaryObjectCounter(0)
+        temporaryObjectCounter(0),
+        currentClone(NULL),
+        currentInstanceByValue(false),
+        currentWithoutInstance(false),
+        currentConstructorInPlace(false)
     {
         // intentionally left blank
     }
 
-    void HandleTranslationUnit(clang::ASTContext &context);
+    void processTranslationUnit(clang::ASTContext &context);
 
     bool TraverseClassTemplateDecl(ClassTemplateDecl *Declaration);
 
@@ -120,6 +313,8 @@ public:
 
     bool TraverseCXXMethodDecl(CXXMethodDecl *Declaration);
 
+    bool TraverseFunctionDecl(FunctionDecl *Declaration);
+
     bool VisitCXXMethodDecl(CXXMethodDecl *Declaration);
 
     bool TraverseFunctionTemplateDecl(FunctionTemplateDecl *Declaration);
@@ -128,6 +323,8 @@ public:
 
     bool TraverseTypeLoc(TypeLoc typeLoc);
 
+    bool TraverseSubstNonTypeTemplateParmExpr(SubstNonTypeTemplateParmExpr *Expression);
+
     bool TraverseCXXOperatorCallExpr(CXXOperatorCallExpr *Expression);
 
     bool VisitCallExpr(CallExpr *Expression);
@@ -136,6 +333,10 @@ public:
 
     bool TraverseCXXMemberCallExpr(CXXMemberCallExpr *Expression);
 
+    bool TraverseMemberExpr(MemberExpr *Expression);
+
+    bool VisitDeclRefExpr(DeclRefExpr *Expression);
+
     bool VisitCXXThisExpr(CXXThisExpr *Expression);
 
     bool TraverseVarDecl(VarDecl *Declaration);
@@ -144,6 +345,8 @@ public:
 
     bool TraverseCompoundStmt(CompoundStmt *Block);
 
+    bool TraverseIfStmt(IfStmt *Statement);
+
     bool TraverseCXXFunctionalCastExpr(CXXFunctionalCastExpr *Expression);
 
     bool TraverseCXXTemporaryObjectExpr(CXXTemporaryObjectExpr *Expression);
@@ -23,20 +23,43 @@
 
 #define SUFFIX_AST_DUMP ".dump"
 
+void PatosConsumer::HandleTranslationUnit(ASTContext &context)
+{
+    // NOTE: errors must not propagate into clang (which is compiled without exceptions)
+    // -> catch them here and let the driver decide how to go on
+    try
+    {
+        this->processTranslationUnit(context);
+    }
+    catch (PatosError const & ex)
+    {
+        ERROR << this->FileName << ": " << ex.what() << std::endl;
+
+        this->failed = true;
+        this->failureMessage = ex.what();
+    }
+}
+
 void PatosConsumer::writeChangesToDisk()
 {
     // "Returns true if any files were not saved successfully..."
     if (this->rewriter->overwriteChangedFiles())
     {
-        ERROR << "unable to write changes to disk" << std::endl;
-        exit(EXIT_FAILURE);
+        FAIL("unable to write changes to disk");
     }
 }
 
 bool PatosConsumer::isInSystemFile(Decl *Declaration)
 {
     SrcMgr::CharacteristicKind kind = this->sourceManager->getFileCharacteristic(Declaration->getLocStart());
-    return kind == SrcMgr::C_System;
+    if (kind == SrcMgr::C_System)
+    {
+        return true;
+    }
+
+    // declarations of the predefines (e.g. OpenCL vector types) are treated like system declarations
+    SourceLocation location = this->sourceManager->getExpansionLoc(Declaration->getLocStart());
+    return location.isValid() && this->sourceManager->getBufferName(location) == "<built-in>";
 }
 
 void PatosConsumer::dumpDeclarationAST(Decl *Declaration, const std::string & subdir)
@@ -41,9 +41,16 @@ protected:
 
     bool isInSystemFile(Decl *Declaration);
 
+    // set if the pass aborted the translation of the file
+    bool failed;
+    std::string failureMessage;
+
+    // the actual work of a pass; may throw a PatosError to abort the translation of the file
+    virtual void processTranslationUnit(ASTContext &context) = 0;
+
 public:
     PatosConsumer(const std::string &FileName, struct Arguments &arguments, Rewriter *rewriter, SourceManager *sourceManager):
-        FileName(FileName), arguments(arguments), rewriter(rewriter), sourceManager(sourceManager)
+        FileName(FileName), arguments(arguments), rewriter(rewriter), sourceManager(sourceManager), failed(false)
     {
         /* intentionally left blank */
     }
@@ -74,6 +81,18 @@ public:
         return this->sourceManager;
     }
 
+    void HandleTranslationUnit(ASTContext &context);
+
+    bool hasFailed() const
+    {
+        return this->failed;
+    }
+
+    const std::string &getFailureMessage() const
+    {
+        return this->failureMessage;
+    }
+
     void writeChangesToDisk();
 
     void dumpDeclarationAST(Decl *Declaration, const std::string & subdir);
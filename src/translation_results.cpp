@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "translation_results.h"
+#include "common.h"
+#include "file_handling.h"
+
+void TranslationResults::addSpecialization(const SpecializationInfo &specialization)
+{
+    auto it = this->specializations.find(specialization.MangledName);
+
+    if (it == this->specializations.end())
+    {
+        this->specializations[specialization.MangledName] = specialization;
+        return;
+    }
+
+    // emitted for several (independent) files -> count the generated code for each of them
+    it->second.GeneratedBytes += specialization.GeneratedBytes;
+
+    if (it->second.Kernel.empty())
+    {
+        it->second.Kernel = specialization.Kernel;
+        it->second.CallChain = specialization.CallChain;
+    }
+}
+
+void TranslationResults::addExplicitInstantiation(const std::string &sourceLine, const std::string &mangledName)
+{
+    this->explicitInstantiations[sourceLine] = mangledName;
+}
+
+bool TranslationResults::getExplicitInstantiation(const std::string &sourceLine, std::string &mangledName) const
+{
+    auto it = this->explicitInstantiations.find(sourceLine);
+    if (it == this->explicitInstantiations.end())
+    {
+        return false;
+    }
+
+    mangledName = it->second;
+    return true;
+}
+
+PRIVATE std::string escapeJSON(const std::string &value)
+{
+    std::stringstream result;
+
+    for (char c : value)
+    {
+        switch (c)
+        {
+            case '"':  result << "\\\""; break;
+            case '\\': result << "\\\\"; break;
+            case '\n': result << "\\n"; break;
+            case '\t': result << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    result << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                }
+                else
+                {
+                    result << c;
+                }
+        }
+    }
+
+    return result.str();
+}
+
+struct TemplateSummary
+{
+    std::string Name;
+    bool IsClassTemplate;
+    unsigned long GeneratedBytes;
+    std::vector<const SpecializationInfo*> Specializations;
+};
+
+bool TranslationResults::writeBloatReport(const std::string &fileName) const
+{
+    // group specializations by their template
+    std::map<std::pair<std::string,bool>, TemplateSummary> templates;
+
+    for (auto &entry : this->specializations)
+    {
+        const SpecializationInfo &specialization = entry.second;
+
+        TemplateSummary &summary = templates[std::make_pair(specialization.TemplateName, specialization.IsClassTemplate)];
+        summary.Name = specialization.TemplateName;
+        summary.IsClassTemplate = specialization.IsClassTemplate;
+        summary.GeneratedBytes += specialization.GeneratedBytes;
+        summary.Specializations.push_back(&specialization);
+    }
+
+    // templates causing the most code first
+    std::vector<const TemplateSummary*> order;
+    for (auto &entry : templates)
+    {
+        order.push_back(&entry.second);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [](const TemplateSummary *a, const TemplateSummary *b)
+    {
+        return a->GeneratedBytes > b->GeneratedBytes;
+    });
+
+    std::stringstream json;
+    std::stringstream table;
+
+    json << "{\n  \"templates\": [";
+
+    table << std::left << std::setw(40) << "template" << std::setw(10) << "kind"
+          << std::right << std::setw(8) << "count" << std::setw(12) << "bytes" << "\n";
+
+    bool firstTemplate = true;
+    for (const TemplateSummary *summary : order)
+    {
+        const char *kind = summary->IsClassTemplate ? "class" : "function";
+
+        json << (firstTemplate ? "\n" : ",\n");
+        json << "    {\n";
+        json << "      \"name\": \"" << escapeJSON(summary->Name) << "\",\n";
+        json << "      \"kind\": \"" << kind << "\",\n";
+        json << "      \"count\": " << summary->Specializations.size() << ",\n";
+        json << "      \"bytes\": " << summary->GeneratedBytes << ",\n";
+        json << "      \"specializations\": [";
+
+        table << "\n" << std::left << std::setw(40) << summary->Name << std::setw(10) << kind
+              << std::right << std::setw(8) << summary->Specializations.size()
+              << std::setw(12) << summary->GeneratedBytes << "\n";
+
+        bool firstSpecialization = true;
+        for (const SpecializationInfo *specialization : summary->Specializations)
+        {
+            json << (firstSpecialization ? "\n" : ",\n");
+            json << "        {\n";
+            json << "          \"mangled\": \"" << escapeJSON(specialization->MangledName) << "\",\n";
+            json << "          \"file\": \"" << escapeJSON(specialization->FileName) << "\",\n";
+            json << "          \"bytes\": " << specialization->GeneratedBytes << ",\n";
+            json << "          \"kernel\": " << (specialization->Kernel.empty() ? "null" : "\"" + escapeJSON(specialization->Kernel) + "\"") << ",\n";
+            json << "          \"chain\": [";
+
+            for (unsigned int i = 0; i < specialization->CallChain.size(); ++i)
+            {
+                json << (i == 0 ? "" : ", ") << "\"" << escapeJSON(specialization->CallChain[i]) << "\"";
+            }
+
+            json << "]\n";
+            json << "        }";
+
+            table << "  " << std::left << std::setw(66) << specialization->MangledName
+                  << std::right << std::setw(12) << specialization->GeneratedBytes << "\n";
+
+            if (specialization->Kernel.empty())
+            {
+                table << "    (not required by any kernel)\n";
+            }
+            else
+            {
+                table << "    required by: ";
+                for (unsigned int i = 0; i < specialization->CallChain.size(); ++i)
+                {
+                    table << (i == 0 ? "" : " -> ") << specialization->CallChain[i];
+                }
+                table << "\n";
+            }
+
+            firstSpecialization = false;
+        }
+
+        json << "\n      ]\n";
+        json << "    }";
+
+        firstTemplate = false;
+    }
+
+    json << "\n  ]\n}\n";
+
+    return writeFile(fileName, json.str()) && writeFile(fileName + ".txt", table.str());
+}
+
+void TranslationResults::addRecordLayout(const RecordLayoutInfo &layout)
+{
+    // records are flattened once per file including them -> the layout is the same for all of them
+    if (this->recordLayouts.find(layout.RecordName) == this->recordLayouts.end())
+    {
+        this->recordLayouts[layout.RecordName] = layout;
+    }
+}
+
+bool TranslationResults::writeLayoutReport(const std::string &fileName) const
+{
+    std::stringstream table;
+
+    unsigned long totalWasted = 0;
+    unsigned long totalOptimizedWasted = 0;
+    unsigned long totalSaved = 0;
+
+    table << std::left << std::setw(50) << "record"
+          << std::right << std::setw(8) << "size" << std::setw(8) << "align" << std::setw(8) << "wasted"
+          << std::setw(12) << "optimized" << std::setw(8) << "wasted" << "  layout\n";
+
+    for (auto &entry : this->recordLayouts)
+    {
+        const RecordLayoutInfo &layout = entry.second;
+
+        std::string status;
+        if (layout.Reordered)
+        {
+            status = "reordered";
+        }
+        else if (!layout.FixedLayoutReason.empty())
+        {
+            status = "kept (" + layout.FixedLayoutReason + ")";
+        }
+        else
+        {
+            status = "kept";
+        }
+
+        table << "\n" << std::left << std::setw(50) << layout.RecordName
+              << std::right << std::setw(8) << layout.Size << std::setw(8) << layout.Alignment << std::setw(8) << layout.WastedBytes
+              << std::setw(12) << layout.OptimizedSize << std::setw(8) << layout.OptimizedWastedBytes << "  " << status << "\n";
+
+        for (const FieldLayoutInfo &field : layout.Fields)
+        {
+            table << "  " << std::left << std::setw(24) << field.Name << std::setw(24) << field.Type
+                  << std::right << std::setw(8) << field.Size << std::setw(8) << field.Alignment
+                  << std::setw(8) << field.Offset << std::setw(12) << field.OptimizedOffset << "\n";
+        }
+
+        totalWasted += layout.WastedBytes;
+        if (layout.Reordered)
+        {
+            totalOptimizedWasted += layout.OptimizedWastedBytes;
+            totalSaved += layout.Size - layout.OptimizedSize;
+        }
+        else
+        {
+            totalOptimizedWasted += layout.WastedBytes;
+        }
+    }
+
+    table << "\n" << this->recordLayouts.size() << " record(s), " << totalWasted << " byte(s) of padding, "
+          << totalOptimizedWasted << " after reordering (" << totalSaved << " byte(s) saved per instance of each record)\n";
+
+    return writeFile(fileName, table.str());
+}
+
+void TranslationResults::addGeneratedFunction(const std::string &name)
+{
+    this->generatedFunctions.insert(name);
+}
+
+bool TranslationResults::isGeneratedFunction(const std::string &name) const
+{
+    return this->generatedFunctions.find(name) != this->generatedFunctions.end();
+}
+
+void TranslationResults::addGeneratedDefinition(const std::string &name, const GeneratedDefinition &definition)
+{
+    // a function is only generated once (by the first file requiring it)
+    if (this->generatedDefinitions.find(name) == this->generatedDefinitions.end())
+    {
+        this->generatedDefinitions[name] = definition;
+    }
+}
+
+const GeneratedDefinition *TranslationResults::getGeneratedDefinition(const std::string &name) const
+{
+    auto it = this->generatedDefinitions.find(name);
+    if (it == this->generatedDefinitions.end())
+    {
+        return NULL;
+    }
+
+    return &it->second;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2016, FAU-Inf3
+ * 
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef __INCLUDE_TRANSLATION_RESULTS_H
+#define __INCLUDE_TRANSLATION_RESULTS_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct SpecializationInfo
+{
+    // name of the class or function template
+    std::string TemplateName;
+    bool IsClassTemplate;
+
+    std::string MangledName;
+
+    // file (relative to the output directory) the specialization has been emitted for
+    std::string FileName;
+
+    // size of the generated code (for records: flattened record and all methods)
+    unsigned long GeneratedBytes;
+
+    // kernel that first requires the specialization along with the chain of
+    // functions/records leading from the kernel to the specialization
+    // (empty if the specialization is not reachable from any kernel)
+    std::string Kernel;
+    std::vector<std::string> CallChain;
+};
+
+struct FieldLayoutInfo
+{
+    std::string Name;
+    std::string Type;
+
+    unsigned long Size;
+    unsigned long Alignment;
+
+    // offset in declaration order and in the optimized order
+    unsigned long Offset;
+    unsigned long OptimizedOffset;
+};
+
+struct RecordLayoutInfo
+{
+    // name of the flattened record
+    std::string RecordName;
+
+    unsigned long Size;
+    unsigned long Alignment;
+    unsigned long WastedBytes;
+
+    // layout with the fields ordered by decreasing alignment
+    unsigned long OptimizedSize;
+    unsigned long OptimizedWastedBytes;
+
+    // the optimized layout has been emitted
+    bool Reordered;
+
+    // why the declaration order has to be kept (empty if the layout may be optimized)
+    std::string FixedLayoutReason;
+
+    // fields in declaration order
+    std::vector<FieldLayoutInfo> Fields;
+};
+
+/**
+ * Information gathered by the transformation pass across all files.
+ */
+// definition of a generated function along with the functions/records it references (by output name)
+struct GeneratedDefinition
+{
+    std::string Code;
+    std::set<std::string> References;
+};
+
+class TranslationResults
+{
+private:
+    // emitted specializations (by mangled name)
+    std::map<std::string, SpecializationInfo> specializations;
+
+    // mangled names of explicitly instantiated kernels (by source line of the explicit instantiation)
+    std::map<std::string, std::string> explicitInstantiations;
+
+    // layouts of the flattened records (by name)
+    std::map<std::string, RecordLayoutInfo> recordLayouts;
+
+    // generated functions (by emitted name) and their definitions, which are inserted into
+    // the file they have been generated for, even if their prototypes are inserted into a header
+    std::set<std::string> generatedFunctions;
+    std::map<std::string, GeneratedDefinition> generatedDefinitions;
+
+public:
+    void addSpecialization(const SpecializationInfo &specialization);
+
+    void addExplicitInstantiation(const std::string &sourceLine, const std::string &mangledName);
+
+    /**
+     * Gets the mangled name of the kernel instantiated by the given source line.
+     *
+     * @return True, if the explicit instantiation has been translated, false otherwise.
+     */
+    bool getExplicitInstantiation(const std::string &sourceLine, std::string &mangledName) const;
+
+    /**
+     * Writes the template instantiation bloat report, i.e. the emitted specializations
+     * grouped by their template, as JSON to the given file and as a table to the given
+     * file with the suffix '.txt'.
+     *
+     * @return True, if the report could be written, false otherwise.
+     */
+    bool writeBloatReport(const std::string &fileName) const;
+
+    void addRecordLayout(const RecordLayoutInfo &layout);
+
+    /**
+     * Writes the layout report, i.e. size, alignment, field offsets and padding of
+     * every flattened record (in declaration order and optimized), as a table to the
+     * given file.
+     *
+     * @return True, if the report could be written, false otherwise.
+     */
+    bool writeLayoutReport(const std::string &fileName) const;
+
+    void addGeneratedFunction(const std::string &name);
+
+    bool isGeneratedFunction(const std::string &name) const;
+
+    void addGeneratedDefinition(const std::string &name, const GeneratedDefinition &definition);
+
+    /**
+     * Gets the definition of a generated function (of any file translated so far).
+     *
+     * @return The definition, or NULL if no definition has been generated.
+     */
+    const GeneratedDefinition *getGeneratedDefinition(const std::string &name) const;
+};
+
+#endif